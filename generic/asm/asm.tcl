@@ -1,6 +1,6 @@
 package req nx::test
-nx::Test parameter count 100000
-#nx::Test parameter count 10
+nx::test configure -count 100000
+#nx::test configure -count 10
 
 proc sum10.tcl {} {
   set sum 0
@@ -291,14 +291,14 @@ nsf::method::asmcreate o check_var2.asm4 {} {
 # self
 #
 nsf::method::create o self.tcl {} {
-  self
+  ::nsf::self
 }
 nsf::method::asmcreate o self.asm1 {} {
-  {obj self}
+  {obj ::nsf::self}
   {eval obj 0}
 }
 nsf::method::asmcreate o self.asm2 {} {
-  {cmd self}
+  {cmd ::nsf::self}
 }
 nsf::method::asmcreate o self.asm3 {} {
   {self}
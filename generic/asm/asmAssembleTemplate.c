@@ -61,17 +61,15 @@ static AsmStatementInfo asmStatementInfo[] = {
 static int 
 AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj, 
 	      int nrArgs, Tcl_Obj *asmObj, AsmCompiledProc **retAsmProc) {
-  AsmPatches patchArray[100], *patches = &patchArray[0], *patchPtr; // TODO: make me dynamic
+  AsmPatches *patchArray, *patches, *patchPtr;
   Tcl_Command cmd;
   AsmCompiledProc *proc;
   AsmInstruction *inst;
-  int i, result, nrAsmInstructions, nrLocalObjs, totalArgvArgs;
+  int i, result, nrAsmInstructions, nrLocalObjs, totalArgvArgs, nrArgReferences;
   int oc, currentAsmInstruction, currentSlot;
   Tcl_Obj **ov;
-  CONST char *procName;
 
   assert(nameObj != NULL);
-  procName = ObjStr(nameObj);
   
   if (Tcl_ListObjGetElements(interp, asmObj, &oc, &ov) != TCL_OK) {
     return NsfPrintError(interp, "Asm code is not a valid list");
@@ -83,6 +81,7 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
   nrAsmInstructions = 0;
   nrLocalObjs = 0;
   totalArgvArgs = 0;
+  nrArgReferences = 0;
 
   for (i = 0; i < oc; i++) {
     int index, offset, wordOc;
@@ -143,6 +142,19 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       //fprintf(stderr, "instruction %s need argvargs %d\n", ObjStr(lineObj), cArgs);
       totalArgvArgs += cArgs;
 
+      /*
+       * Every "arg" word might result in an argument reference.
+       */
+      if ((asmStatementInfo[index].flags & ASM_INFO_PAIRS) != 0) {
+        int j;
+
+        for (j = offset; j < wordOc; j += 2) {
+          if (strcmp(ObjStr(wordOv[j]), "arg") == 0) {
+            nrArgReferences ++;
+          }
+        }
+      }
+
       nrAsmInstructions++;
     } else {
       /* currently obj and var from the same pool, will change... */
@@ -173,31 +185,44 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
   }
 
   nrAsmInstructions ++;
-  fprintf(stderr, "%s: nrAsmInstructions %d nrLocalObjs %d nrArgs %d argvArgs %d => data %d\n", 
-	  procName, nrAsmInstructions, nrLocalObjs, nrArgs, totalArgvArgs, 
-	  nrLocalObjs + nrArgs + totalArgvArgs );
+  /*fprintf(stderr, "%s: nrAsmInstructions %d nrLocalObjs %d nrArgs %d argvArgs %d => data %d\n",
+	  ObjStr(nameObj), nrAsmInstructions, nrLocalObjs, nrArgs, totalArgvArgs,
+	  nrLocalObjs + nrArgs + totalArgvArgs );*/
 
   /*
-   * Allocate structures
+   * Allocate structures; all sizes are determined by the first
+   * iteration. The objs hold the arguments, followed by the slots and
+   * the argument vectors of the instructions.
    */
 
   proc = (AsmCompiledProc *)ckalloc(sizeof(AsmCompiledProc));
   proc->code = (AsmInstruction *)ckalloc(sizeof(AsmInstruction) * nrAsmInstructions);
-  memset(proc->slotFlags, 0, sizeof(int) * NSF_ASM_NR_STATIC_SLOTS);
+  proc->objs = (Tcl_Obj **)ckalloc(sizeof(Tcl_Obj *) * (nrArgs + nrLocalObjs + totalArgvArgs + 1));
+  memset(proc->objs, 0, sizeof(Tcl_Obj *) * (nrArgs + nrLocalObjs + totalArgvArgs + 1));
+  proc->slotFlags = (int *)ckalloc(sizeof(int) * (nrLocalObjs + 1));
+  memset(proc->slotFlags, 0, sizeof(int) * (nrLocalObjs + 1));
+  proc->argReferences = (AsmArgReference *)ckalloc(sizeof(AsmArgReference) * (nrArgReferences + 1));
+  proc->literalsObj = Tcl_NewListObj(0, NULL);
+  INCR_REF_COUNT(proc->literalsObj);
+  proc->resolverInfos = NULL;
+  proc->currentObject = NULL;
+  proc->status = 0;
+  proc->active = 0;
 
   proc->ip = proc->code;  /* points to the first writable instructon */
-  proc->firstObj = proc->staticObjs;  /* point to the first free obj */
-  proc->locals = proc->staticObjs;    /* locals is just an alias     */
+  proc->firstObj = proc->objs;  /* point to the first free obj */
+  proc->locals = proc->objs;    /* locals is just an alias     */
   proc->nrAsmArgReferences = 0;
   proc->slots = proc->locals + nrArgs;
   //fprintf(stderr, "args = %ld\n", proc->slots - proc->locals);
 
   AsmLocalsAlloc(proc, nrArgs + nrLocalObjs);
-  /* when freeing, we need something like 
-    for (i=0; i < nrArgs + nrLocalObjs; i++) { 
-      if (proc->slotFlags[i] & ASM_SLOT_MUST_DECR) {Tcl_DecrRefCount(proc->slots[i]); }
-    }
-  */
+
+  /*
+   * There is at most one patch per instruction.
+   */
+  patchArray = (AsmPatches *)ckalloc(sizeof(AsmPatches) * nrAsmInstructions);
+  patches = patchArray;
 
   /*
    * Second Iteration: emit code
@@ -235,6 +260,7 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       inst->clientData = ((Command *)cmd)->objClientData;
       /* use the assembly word as cmd name; should be ok when we keep assembly around */
       inst->argv[0] = argv[1];
+      AsmLiteralKeep(proc, argv[1]);
       /*fprintf(stderr, "[%d] %s/%d\n", currentAsmInstruction, Tcl_GetString(argv[1]), 1+((argc-offset)/2));*/
 
       AsmInstructionArgvSet(interp, offset, argc, 1, inst, proc, argv, 0);
@@ -260,13 +286,14 @@ $ASSEMBLE_EMIT_CODE
    * from above.
    */
 
-  for (patchPtr = &patchArray[0]; patchPtr < patches; patchPtr++) {
-    fprintf(stderr, "wanna patch code[%d]->argv = code[%d]->argv[%d]\n",
-	    patchPtr->targetAsmInstruction, patchPtr->sourceAsmInstruction, patchPtr->argvIndex);
+  for (patchPtr = patchArray; patchPtr < patches; patchPtr++) {
+    /*fprintf(stderr, "patch code[%d]->argv = code[%d]->argv[%d]\n",
+      patchPtr->targetAsmInstruction, patchPtr->sourceAsmInstruction, patchPtr->argvIndex);*/
     /* set the argument vector of code[1] to the address of code[4]->argv[1] */
     (&proc->code[patchPtr->targetAsmInstruction])->argv = 
       &(&proc->code[patchPtr->sourceAsmInstruction])->argv[patchPtr->argvIndex];
   }
+  ckfree((char *)patchArray);
 
   *retAsmProc = proc;
 
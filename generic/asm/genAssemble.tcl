@@ -29,7 +29,7 @@ nsf::proc writeFile {fn content} {
 # Basic Class for Instructions and Declarations
 ######################################################################
 nx::Class create Statement {
-  :property {name "[namespace tail [self]]"}
+  :property {name:substdefault "[namespace tail [self]]"}
   :property {mustContainPairs true}
   :property {argTypes NULL}
   :property {minArgs 0}
@@ -47,17 +47,17 @@ nx::Class create Statement {
     return ${:asmEmitCode}
   }
 
-  :public class method "generate assembler" {} {
+  :public object method "generate assembler" {} {
     set statementIndex {}
     set statementNames {}
     set (ASSEMBLE_EMIT_CODE) ""
     foreach s [lsort [Statement info instances -closure]] {
-      if {[$s maxArgs] == 0} {
+      if {[$s cget -maxArgs] == 0} {
 	puts stderr "ignore statement $s"
 	continue
       }
       lappend statementIndex [$s cName]Idx
-      lappend statementNames \"[$s name]\"
+      lappend statementNames \"[$s cget -name]\"
       
       set emitCode [$s getAsmEmitCode]
       if {$emitCode ne ""} {
@@ -68,11 +68,11 @@ nx::Class create Statement {
       if {[$s info has type ::Declaration]} {
 	lappend flags ASM_INFO_DECL
       }
-      if {[$s mustContainPairs]} {
+      if {[$s cget -mustContainPairs]} {
 	lappend flags ASM_INFO_PAIRS
       }
       lappend statementInfo \
-	  "/* [$s cName] */\n  {[join $flags |], [$s argTypes], [$s minArgs], [$s maxArgs], [$s cArgs]}"
+	  "/* [$s cName] */\n  {[join $flags |], [$s cget -argTypes], [$s cget -minArgs], [$s cget -maxArgs], [$s cget -cArgs]}"
     }
     array set {} [list \
 	STATEMENT_INDICES [join $statementIndex ",\n  "] \
@@ -106,6 +106,10 @@ nx::Class create Instruction -superclass Statement {
   # where we have to pass proc via inst->clientData
   :property {execNeedsProc false}
 
+  :public method asmEmitCode {} {
+    return ${:asmEmitCode}
+  }
+
   :public method getAsmEmitCode {} {
     #
     # For every instruction, the C-code allocates an instruction record
@@ -147,8 +151,8 @@ nx::Class create Instruction -superclass Statement {
 
 nx::Class create LabelThreading {
 
-  :public class method generate {} {
-    Instruction mixin add [self]::Instruction
+  :public object method generate {} {
+    Instruction mixins add [self]::Instruction
     set instructions [lsort [Instruction info instances]]
     set labels {}
     set indices {}
@@ -163,7 +167,7 @@ nx::Class create LabelThreading {
 	INSTRUCTION_INDICES [join $indices ",\n  "] \
         {*}[Statement generate assembler]]
 
-    Instruction mixin delete [self]::Instruction
+    Instruction mixins delete [self]::Instruction
     return [array get {}]
   }
 
@@ -175,7 +179,7 @@ nx::Class create LabelThreading {
       return INST_[:cName]
     }
     :method nextInstruction {} {
-      if {[:isJump]} {
+      if {${:isJump}} {
 	:code mustContain NsfAsmJump
 	:code append "\n  goto *instructionLabel\[ip->labelIdx];\n"
       } else {
@@ -184,7 +188,7 @@ nx::Class create LabelThreading {
     }
     :public method "code generate" {} {
       :code append ${:execCode}
-      if {[:returnsResult]} {
+      if {${:returnsResult}} {
 	:code mustAssign result
 	:code append "  goto EXEC_RESULT_CODE_HANDLER;\n"
       }
@@ -206,9 +210,9 @@ nx::Class create LabelThreading {
 
 nx::Class create CallThreading {
 
-  :public class method generate {} {
-    Instruction mixin add [self]::Instruction
-    Statement   mixin add [self]::Statement
+  :public object method generate {} {
+    Instruction mixins add [self]::Instruction
+    Statement   mixins add [self]::Statement
 
     foreach instruction [lsort [Instruction info instances]] {
       append (GENERATED_INSTRUCTIONS) [$instruction generate] \n
@@ -216,8 +220,8 @@ nx::Class create CallThreading {
 
     array set {} [Statement generate assembler]
 
-    Instruction mixin delete [self]::Instruction
-    Statement   mixin delete [self]::Statement
+    Instruction mixins delete [self]::Instruction
+    Statement   mixins delete [self]::Statement
 
     return [array get {}]
   }
@@ -226,7 +230,7 @@ nx::Class create CallThreading {
 
     :public method asmEmitCode {} {
       set asmEmitCode ${:asmEmitCode}
-      if {[:execNeedsProc]} {
+      if {${:execNeedsProc}} {
 	append asmEmitCode "\n\tinst->clientData = proc;\n"
       }
       return $asmEmitCode
@@ -244,12 +248,12 @@ nx::Class create CallThreading {
       regsub -all {\mip->argc\M} $code argc code
       regsub -all {\mip->clientData\M} $code clientData code
 
-      if {[:isJump]} {
+      if {${:isJump}} {
 	regsub -all {\mip\s*= } $code "proc->ip = " code
 	regsub -all {\mip\s*[+][+]} $code "proc->ip++" code
       }
 
-      if {[:returnsResult]} {
+      if {${:returnsResult}} {
 	:code append "  int result;\n"
 	:code append $code
 	:code mustAssign result
@@ -264,7 +268,7 @@ nx::Class create CallThreading {
       :code clear
       :code append \
 	  "static int [:cName](ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv\[]) \{\n"
-      if {[:execNeedsProc]} {
+      if {${:execNeedsProc}} {
 	:code append "  AsmCompiledProc *proc = clientData;\n"
       }
       :code generate
@@ -304,10 +308,10 @@ namespace eval ::asm {
       -minArgs 3 -maxArgs 3 -argTypes asmStatementIntType \
       -asmEmitCode {
 	{
-	  int intValue;
-	  Tcl_GetIntFromObj(interp, argv[2], &intValue);
-	  proc->slots[currentSlot] = INT2PTR(intValue);
-	  //fprintf(stderr, "setting slots [%d] = %d\n", currentSlot, intValue);
+	  long longValue;
+	  Tcl_GetLongFromObj(interp, argv[2], &longValue);
+	  proc->slots[currentSlot] = ASM_LONG_SLOT(longValue);
+	  //fprintf(stderr, "setting slots [%d] = %ld\n", currentSlot, longValue);
 	  proc->slotFlags[currentSlot] |= ASM_SLOT_IS_INTEGER;
 	  currentSlot ++;
 	}
@@ -351,7 +355,7 @@ namespace eval ::asm {
 	  }
 	  if (cmd && object) {
 	    // experimental: bind obj and method
-	    resInfo = NEW(AsmResolverInfo); // TODO: LEAK
+	    resInfo = AsmResolverInfoNew(proc);
 	    resInfo->cmd = cmd;
 	    resInfo->object = object;
 	    inst->clientData = resInfo;
@@ -414,9 +418,8 @@ namespace eval ::asm {
 	  } else {
 	    //fprintf(stderr, "%s: asmMethodSelfDispatch cmd '%s'\n", procName, ObjStr(inst->argv[0]));
 	  }
-	  resInfo = NEW(AsmResolverInfo); // TODO: LEAK
+	  resInfo = AsmResolverInfoNew(proc);
 	  resInfo->cmd = cmd;
-	  resInfo->proc = proc;
 	  inst->clientData = resInfo;
 	}
       } \
@@ -447,6 +450,45 @@ namespace eval ::asm {
 	}
       }
 
+  # {selfDispatch obj 0 obj 1 arg 0}
+  # Call a method on the current object. The method is looked up via
+  # the inline cache of the instruction (see AsmDispatch()).
+  Instruction create selfDispatch \
+      -minArgs 3 -maxArgs -1 -cArgs NR_PAIRS -argTypes asmStatementCmdType \
+      -asmEmitCode {
+	inst->clientData = AsmResolverInfoNew(proc);
+      } \
+      -returnsResult true \
+      -execCode {
+	{
+	  AsmResolverInfo *resInfo = ip->clientData;
+	  result = AsmDispatch(interp, resInfo, resInfo->proc->currentObject, ip->argc, ip->argv);
+	}
+      }
+
+  # {objDispatch arg 0 obj 1 obj 2}
+  # Call a method on the object named by the first argument via the
+  # inline cache of the instruction. When the first argument is not
+  # an object, the words are evaluated as a command.
+  Instruction create objDispatch \
+      -minArgs 5 -maxArgs -1 -cArgs NR_PAIRS -argTypes asmStatementCmdType \
+      -asmEmitCode {
+	inst->clientData = AsmResolverInfoNew(proc);
+      } \
+      -returnsResult true \
+      -execCode {
+	{
+	  AsmResolverInfo *resInfo = ip->clientData;
+	  NsfObject *object;
+
+	  if (likely(GetObjectFromObj(interp, ip->argv[0], &object) == TCL_OK)) {
+	    result = AsmDispatch(interp, resInfo, object, ip->argc-1, ip->argv+1);
+	  } else {
+	    result = Tcl_EvalObjv(interp, ip->argc, ip->argv, 0);
+	  }
+	}
+      }
+
   # {self} 
 
   Instruction create self \
@@ -485,33 +527,16 @@ namespace eval ::asm {
       }
   
   # {leIntObj slot 4 slot 7}
-
+  # Compare the values of two object slots like "<=" of expr; only
+  # integers fitting into a long are compared without a call to Tcl.
   Instruction create leIntObj \
       -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
       -execNeedsProc true \
+      -returnsResult true \
       -execCode {
-	{
-	  int value1, value2;
-	  Tcl_Obj *obj;
-	  //fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", ip->argc, ip->argv[0], ip->argv[1]);
-	  
-	  // for the time being, we compare two int values
-	  obj = proc->slots[PTR2INT(ip->argv[0])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value1 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value1);
-	  }
-	  obj = proc->slots[PTR2INT(ip->argv[1])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value2 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value2);
-	  }
-	  //fprintf(stderr, "asmLeScalar oc %d op1 %d op2 %d => %d\n", ip->argc, value1, value2, value1 <= value2);
-	  
-	  proc->status = value1 <= value2;
-	}
+	//fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", ip->argc, ip->argv[0], ip->argv[1]);
+	result = AsmObjLe(interp, proc->slots[PTR2INT(ip->argv[0])], proc->slots[PTR2INT(ip->argv[1])],
+			  &proc->status);
       }
 
   # {leInt slot 4 slot 7}
@@ -521,9 +546,9 @@ namespace eval ::asm {
       -execNeedsProc true \
       -execCode {
 	{
-	  int value1, value2;
-	  value1 = PTR2INT(proc->slots[PTR2INT(ip->argv[0])]);
-	  value2 = PTR2INT(proc->slots[PTR2INT(ip->argv[1])]);
+	  long value1, value2;
+	  value1 = ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])]);
+	  value2 = ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]);
 	  proc->status = value1 <= value2;
 	}
       }
@@ -567,6 +592,68 @@ namespace eval ::asm {
 	proc->slots[PTR2INT(ip->argv[0])] = ip->argv[1];
       }
 
+  # {setIntSlot slot 6 slot 7}
+  Instruction create setIntSlot \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
+      -execNeedsProc true \
+      -execCode {
+	proc->slots[PTR2INT(ip->argv[0])] = proc->slots[PTR2INT(ip->argv[1])];
+      }
+
+  # {unboxInt slot 6 arg 0}
+  # Load an argument into an integer slot. Typed arguments were
+  # already checked by the converters of the parameter definitions,
+  # the integer has to fit into a long.
+  Instruction create unboxInt \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotObjArgType \
+      -execNeedsProc true \
+      -returnsResult true \
+      -execCode {
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, ip->argv[1], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+      }
+
+  # {unboxIntSlot slot 6 slot 7}
+  Instruction create unboxIntSlot \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
+      -execNeedsProc true \
+      -returnsResult true \
+      -execCode {
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, proc->slots[PTR2INT(ip->argv[1])], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+      }
+
+  # {boxInt slot 6 slot 7}
+  # Set an object slot to the value of an integer slot.
+  Instruction create boxInt \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
+      -execNeedsProc true \
+      -execCode {
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      }
+
   # {setObjToResult slot 5}
   Instruction create setObjToResult \
       -minArgs 3 -maxArgs 3 -cArgs 2 -argTypes asmStatementSlotType \
@@ -576,6 +663,89 @@ namespace eval ::asm {
 	proc->slots[PTR2INT(ip->argv[0])] = Tcl_GetObjResult(interp);
       }
   
+  # {duplicateSlot slot 6 slot 7}
+  Instruction create duplicateSlot \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
+      -execNeedsProc true \
+      -execCode {
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(proc->slots[PTR2INT(ip->argv[1])]);
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      }
+
+  # {duplicateResult slot 6}
+  Instruction create duplicateResult \
+      -minArgs 3 -maxArgs 3 -cArgs 1 -argTypes asmStatementSlotType \
+      -execNeedsProc true \
+      -execCode {
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(Tcl_GetObjResult(interp));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      }
+
+  # {getInstVar slot 6 obj 2}
+  Instruction create getInstVar \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotObjArgType \
+      -execNeedsProc true \
+      -returnsResult true \
+      -execCode {
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Nsf_ObjGetVar2((Nsf_Object *)proc->currentObject, interp,
+					     ip->argv[1], NULL, TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    valueObj = Tcl_DuplicateObj(valueObj);
+	    Tcl_IncrRefCount(valueObj);
+	    if (proc->slots[indexValue]) {
+	      Tcl_DecrRefCount(proc->slots[indexValue]);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+      }
+
+  # {setInstVar obj 2 slot 6}
+  # The instance variable receives a copy, since slot values might be
+  # modified in place (e.g. by incrObj).
+  Instruction create setInstVar \
+      -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotObjArgType \
+      -execNeedsProc true \
+      -returnsResult true \
+      -execCode {
+	{
+	  Tcl_Obj *valueObj = Nsf_ObjSetVar2((Nsf_Object *)proc->currentObject, interp,
+					     ip->argv[0], NULL,
+					     Tcl_DuplicateObj(proc->slots[PTR2INT(ip->argv[1])]),
+					     TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    Tcl_SetObjResult(interp, valueObj);
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+      }
+
   # {setResult slot 6}
   Instruction create setResult \
       -minArgs 3 -maxArgs 3 -cArgs 1 -argTypes asmStatementSlotType \
@@ -589,7 +759,7 @@ namespace eval ::asm {
       -minArgs 3 -maxArgs 3 -cArgs 1 -argTypes asmStatementSlotType \
       -execNeedsProc true \
       -execCode {
-	Tcl_SetObjResult(interp, Tcl_NewIntObj(PTR2INT(proc->slots[PTR2INT(ip->argv[0])])));
+	Tcl_SetObjResult(interp, Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])])));
       }
 
   # {store code 4 argv 2}
@@ -618,59 +788,50 @@ namespace eval ::asm {
 	Tcl_IncrRefCount(ip->argv[0]);
       }
 
-  # {incrObj slot 6 slot 7} 
+  # {incrObj slot 6 slot 7}
+  # Increment the value of an object slot like incr. Unshared objects
+  # are modified in place, shared ones are replaced in the slot.
   Instruction create incrObj \
       -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
       -execNeedsProc true \
+      -returnsResult true \
       -execCode {
 	{
-	  int intValue, incrValue;
-	  Tcl_Obj *intObj, *incrObj;
-	  
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *intObj = proc->slots[indexValue], *valueObj;
+
 	  //fprintf(stderr, "asmIncrScalar var[%d] incr var[%d], ", PTR2INT(ip->argv[0]), PTR2INT(ip->argv[1]));
-	  
-	  intObj = proc->slots[PTR2INT(ip->argv[0])];
-	  incrObj = proc->slots[PTR2INT(ip->argv[1])];
-	  
-	  if (likely(intObj->typePtr == Nsf_OT_intType)) {
-	    intValue = intObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, intObj, &intValue);
-	  }
-	  
-	  if (likely(incrObj->typePtr == Nsf_OT_intType)) {
-	    incrValue = incrObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, incrObj, &incrValue);
+
+	  result = AsmObjIncr(interp, intObj, proc->slots[PTR2INT(ip->argv[1])], &valueObj);
+	  if (likely(result == TCL_OK) && valueObj != intObj) {
+	    Tcl_IncrRefCount(valueObj);
+	    if ((proc->slotFlags[indexValue] & ASM_SLOT_MUST_DECR) != 0) {
+	      Tcl_DecrRefCount(intObj);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
 	  }
-	  
-	  //fprintf(stderr, "%d + %d = %d,", intValue, incrValue, intValue + incrValue);
-	  
-	  Tcl_InvalidateStringRep(intObj);
-	  intObj->internalRep.longValue = (long)(intValue + incrValue);
-	  
-	  //fprintf(stderr, "updated %p var[%d] %p\n",  intObj, PTR2INT(ip->argv[0]), proc->slots[PTR2INT(ip->argv[0])]);
-	  
-	  //Tcl_SetObjResult(interp, intObj);
 	}
-      } 
+      }
 
-  # {incrInt slot 6 slot 7} 
+  # {incrInt slot 6 slot 7}
   Instruction create incrInt \
       -minArgs 5 -maxArgs 5 -cArgs 2 -argTypes asmStatementSlotType \
       -execNeedsProc true \
+      -returnsResult true \
       -execCode {
 	{
-	  int intValue, incrValue;
+	  long longValue;
 	  //fprintf(stderr, "incrInt var[%d] incr var[%d]\n", PTR2INT(ip->argv[0]), PTR2INT(ip->argv[1]));
-	  intValue  = PTR2INT(proc->slots[PTR2INT(ip->argv[0])]);
-	  incrValue = PTR2INT(proc->slots[PTR2INT(ip->argv[1])]);
-	  //fprintf(stderr, ".... intValue %d incr Value %d\n", intValue, incrValue);
-	  
-	  proc->slots[PTR2INT(ip->argv[0])] = INT2PTR(intValue + incrValue);
-	  //fprintf(stderr, ".... [%d] => %d\n", PTR2INT(ip->argv[0]), intValue + incrValue);
+	  result = AsmLongAdd(interp,
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])]),
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]),
+			      &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
 	}
-      } 
+      }
 
 }
 
@@ -1,7 +1,11 @@
 enum asmStatementIndex {
   asmObjProcIdx, 
+  asmBoxIntIdx,
   asmEvalIdx,
   asmDuplicateObjIdx,
+  asmDuplicateResultIdx,
+  asmDuplicateSlotIdx,
+  asmGetInstVarIdx,
   asmIncrIntIdx,
   asmIncrObjIdx,
   asmIntegerIdx,
@@ -13,20 +17,30 @@ enum asmStatementIndex {
   asmMethodSelfDispatchIdx,
   asmNoopIdx,
   asmObjIdx,
+  asmObjDispatchIdx,
   asmSelfIdx,
+  asmSelfDispatchIdx,
+  asmSetInstVarIdx,
   asmSetIntIdx,
+  asmSetIntSlotIdx,
   asmSetObjIdx,
   asmSetObjToResultIdx,
   asmSetResultIdx,
   asmSetResultIntIdx,
   asmStoreResultIdx,
+  asmUnboxIntIdx,
+  asmUnboxIntSlotIdx,
   asmVarIdx
 };
 
 static CONST char *asmStatementNames[] = {
   "cmd", 
+  "boxInt",
   "eval",
   "duplicateObj",
+  "duplicateResult",
+  "duplicateSlot",
+  "getInstVar",
   "incrInt",
   "incrObj",
   "integer",
@@ -38,13 +52,19 @@ static CONST char *asmStatementNames[] = {
   "methodSelfDispatch",
   "noop",
   "obj",
+  "objDispatch",
   "self",
+  "selfDispatch",
+  "setInstVar",
   "setInt",
+  "setIntSlot",
   "setObj",
   "setObjToResult",
   "setResult",
   "setResultInt",
   "storeResult",
+  "unboxInt",
+  "unboxIntSlot",
   "var",
   NULL
 };
@@ -83,10 +103,18 @@ static CONST char *asmStatementStoreType[]       = {"instruction", "argv", NULL}
 static AsmStatementInfo asmStatementInfo[] = {
   /* asmObjProcIdx, */
   {ASM_INFO_PAIRS|ASM_INFO_SKIP1, NULL, 2, -1, NR_PAIRS1},
+  /* asmBoxInt */
+  {0|ASM_INFO_PAIRS, asmStatementSlotType, 5, 5, 2},
   /* asmEval */
   {0|ASM_INFO_PAIRS, asmStatementCmdType, 3, -1, NR_PAIRS},
   /* asmDuplicateObj */
   {0|ASM_INFO_PAIRS, asmStatementSlotObjArgType, 5, 5, 2},
+  /* asmDuplicateResult */
+  {0|ASM_INFO_PAIRS, asmStatementSlotType, 3, 3, 1},
+  /* asmDuplicateSlot */
+  {0|ASM_INFO_PAIRS, asmStatementSlotType, 5, 5, 2},
+  /* asmGetInstVar */
+  {0|ASM_INFO_PAIRS, asmStatementSlotObjArgType, 5, 5, 2},
   /* asmIncrInt */
   {0|ASM_INFO_PAIRS, asmStatementSlotType, 5, 5, 2},
   /* asmIncrObj */
@@ -109,10 +137,18 @@ static AsmStatementInfo asmStatementInfo[] = {
   {0, NULL, 1, 1, 0},
   /* asmObj */
   {0|ASM_INFO_DECL, NULL, 2, 2, 0},
+  /* asmObjDispatch */
+  {0|ASM_INFO_PAIRS, asmStatementCmdType, 5, -1, NR_PAIRS},
   /* asmSelf */
   {0|ASM_INFO_PAIRS, NULL, 1, 1, 0},
+  /* asmSelfDispatch */
+  {0|ASM_INFO_PAIRS, asmStatementCmdType, 3, -1, NR_PAIRS},
+  /* asmSetInstVar */
+  {0|ASM_INFO_PAIRS, asmStatementSlotObjArgType, 5, 5, 2},
   /* asmSetInt */
   {0|ASM_INFO_PAIRS, asmStatementSlotIntType, 5, 5, 2},
+  /* asmSetIntSlot */
+  {0|ASM_INFO_PAIRS, asmStatementSlotType, 5, 5, 2},
   /* asmSetObj */
   {0|ASM_INFO_PAIRS, asmStatementSlotObjArgType, 5, 5, 2},
   /* asmSetObjToResult */
@@ -123,6 +159,10 @@ static AsmStatementInfo asmStatementInfo[] = {
   {0|ASM_INFO_PAIRS, asmStatementSlotType, 3, 3, 1},
   /* asmStoreResult */
   {0|ASM_INFO_PAIRS, asmStatementStoreType, 5, 5, 0},
+  /* asmUnboxInt */
+  {0|ASM_INFO_PAIRS, asmStatementSlotObjArgType, 5, 5, 2},
+  /* asmUnboxIntSlot */
+  {0|ASM_INFO_PAIRS, asmStatementSlotType, 5, 5, 2},
   /* asmVar */
   {0|ASM_INFO_DECL|ASM_INFO_PAIRS, asmStatementObjType, 3, 3, 0}
 };
@@ -142,17 +182,15 @@ static AsmStatementInfo asmStatementInfo[] = {
 static int 
 AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj, 
 	      int nrArgs, Tcl_Obj *asmObj, AsmCompiledProc **retAsmProc) {
-  AsmPatches patchArray[100], *patches = &patchArray[0], *patchPtr; // TODO: make me dynamic
+  AsmPatches *patchArray, *patches, *patchPtr;
   Tcl_Command cmd;
   AsmCompiledProc *proc;
   AsmInstruction *inst;
-  int i, result, nrAsmInstructions, nrLocalObjs, totalArgvArgs;
+  int i, result, nrAsmInstructions, nrLocalObjs, totalArgvArgs, nrArgReferences;
   int oc, currentAsmInstruction, currentSlot;
   Tcl_Obj **ov;
-  CONST char *procName;
 
   assert(nameObj != NULL);
-  procName = ObjStr(nameObj);
   
   if (Tcl_ListObjGetElements(interp, asmObj, &oc, &ov) != TCL_OK) {
     return NsfPrintError(interp, "Asm code is not a valid list");
@@ -164,6 +202,7 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
   nrAsmInstructions = 0;
   nrLocalObjs = 0;
   totalArgvArgs = 0;
+  nrArgReferences = 0;
 
   for (i = 0; i < oc; i++) {
     int index, offset, wordOc;
@@ -224,6 +263,19 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       //fprintf(stderr, "instruction %s need argvargs %d\n", ObjStr(lineObj), cArgs);
       totalArgvArgs += cArgs;
 
+      /*
+       * Every "arg" word might result in an argument reference.
+       */
+      if ((asmStatementInfo[index].flags & ASM_INFO_PAIRS) != 0) {
+        int j;
+
+        for (j = offset; j < wordOc; j += 2) {
+          if (strcmp(ObjStr(wordOv[j]), "arg") == 0) {
+            nrArgReferences ++;
+          }
+        }
+      }
+
       nrAsmInstructions++;
     } else {
       /* currently obj and var from the same pool, will change... */
@@ -254,31 +306,44 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
   }
 
   nrAsmInstructions ++;
-  fprintf(stderr, "%s: nrAsmInstructions %d nrLocalObjs %d nrArgs %d argvArgs %d => data %d\n", 
-	  procName, nrAsmInstructions, nrLocalObjs, nrArgs, totalArgvArgs, 
-	  nrLocalObjs + nrArgs + totalArgvArgs );
+  /*fprintf(stderr, "%s: nrAsmInstructions %d nrLocalObjs %d nrArgs %d argvArgs %d => data %d\n",
+	  ObjStr(nameObj), nrAsmInstructions, nrLocalObjs, nrArgs, totalArgvArgs,
+	  nrLocalObjs + nrArgs + totalArgvArgs );*/
 
   /*
-   * Allocate structures
+   * Allocate structures; all sizes are determined by the first
+   * iteration. The objs hold the arguments, followed by the slots and
+   * the argument vectors of the instructions.
    */
 
   proc = (AsmCompiledProc *)ckalloc(sizeof(AsmCompiledProc));
   proc->code = (AsmInstruction *)ckalloc(sizeof(AsmInstruction) * nrAsmInstructions);
-  memset(proc->slotFlags, 0, sizeof(int) * NSF_ASM_NR_STATIC_SLOTS);
+  proc->objs = (Tcl_Obj **)ckalloc(sizeof(Tcl_Obj *) * (nrArgs + nrLocalObjs + totalArgvArgs + 1));
+  memset(proc->objs, 0, sizeof(Tcl_Obj *) * (nrArgs + nrLocalObjs + totalArgvArgs + 1));
+  proc->slotFlags = (int *)ckalloc(sizeof(int) * (nrLocalObjs + 1));
+  memset(proc->slotFlags, 0, sizeof(int) * (nrLocalObjs + 1));
+  proc->argReferences = (AsmArgReference *)ckalloc(sizeof(AsmArgReference) * (nrArgReferences + 1));
+  proc->literalsObj = Tcl_NewListObj(0, NULL);
+  INCR_REF_COUNT(proc->literalsObj);
+  proc->resolverInfos = NULL;
+  proc->currentObject = NULL;
+  proc->status = 0;
+  proc->active = 0;
 
   proc->ip = proc->code;  /* points to the first writable instructon */
-  proc->firstObj = proc->staticObjs;  /* point to the first free obj */
-  proc->locals = proc->staticObjs;    /* locals is just an alias     */
+  proc->firstObj = proc->objs;  /* point to the first free obj */
+  proc->locals = proc->objs;    /* locals is just an alias     */
   proc->nrAsmArgReferences = 0;
   proc->slots = proc->locals + nrArgs;
   //fprintf(stderr, "args = %ld\n", proc->slots - proc->locals);
 
   AsmLocalsAlloc(proc, nrArgs + nrLocalObjs);
-  /* when freeing, we need something like 
-    for (i=0; i < nrArgs + nrLocalObjs; i++) { 
-      if (proc->slotFlags[i] & ASM_SLOT_MUST_DECR) {Tcl_DecrRefCount(proc->slots[i]); }
-    }
-  */
+
+  /*
+   * There is at most one patch per instruction.
+   */
+  patchArray = (AsmPatches *)ckalloc(sizeof(AsmPatches) * nrAsmInstructions);
+  patches = patchArray;
 
   /*
    * Second Iteration: emit code
@@ -316,12 +381,21 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       inst->clientData = ((Command *)cmd)->objClientData;
       /* use the assembly word as cmd name; should be ok when we keep assembly around */
       inst->argv[0] = argv[1];
+      AsmLiteralKeep(proc, argv[1]);
       /*fprintf(stderr, "[%d] %s/%d\n", currentAsmInstruction, Tcl_GetString(argv[1]), 1+((argc-offset)/2));*/
 
       AsmInstructionArgvSet(interp, offset, argc, 1, inst, proc, argv, 0);
       break;
 
       /* begin generated code */
+   case asmBoxIntIdx:
+
+	inst = AsmInstructionNew(proc, asmBoxInt, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
    case asmEvalIdx:
 
 	inst = AsmInstructionNew(proc, asmEval, cArgs);
@@ -336,6 +410,30 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
 
       break;
 
+   case asmDuplicateResultIdx:
+
+	inst = AsmInstructionNew(proc, asmDuplicateResult, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
+   case asmDuplicateSlotIdx:
+
+	inst = AsmInstructionNew(proc, asmDuplicateSlot, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
+   case asmGetInstVarIdx:
+
+	inst = AsmInstructionNew(proc, asmGetInstVar, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
    case asmIncrIntIdx:
 
 	inst = AsmInstructionNew(proc, asmIncrInt, cArgs);
@@ -355,10 +453,10 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
    case asmIntegerIdx:
 
 	{
-	  int intValue;
-	  Tcl_GetIntFromObj(interp, argv[2], &intValue);
-	  proc->slots[currentSlot] = INT2PTR(intValue);
-	  //fprintf(stderr, "setting slots [%d] = %d\n", currentSlot, intValue);
+	  long longValue;
+	  Tcl_GetLongFromObj(interp, argv[2], &longValue);
+	  proc->slots[currentSlot] = ASM_LONG_SLOT(longValue);
+	  //fprintf(stderr, "setting slots [%d] = %ld\n", currentSlot, longValue);
 	  proc->slotFlags[currentSlot] |= ASM_SLOT_IS_INTEGER;
 	  currentSlot ++;
 	}
@@ -415,12 +513,12 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
 	  }
 	  if (cmd && object) {
 	    // experimental: bind obj and method
-	    resInfo = NEW(AsmResolverInfo); // TODO: LEAK
+	    resInfo = AsmResolverInfoNew(proc);
 	    resInfo->cmd = cmd;
 	    resInfo->object = object;
 	    inst->clientData = resInfo;
 	    AsmInstructionSetCmd(inst, asmMethodDelegateDispatch11);
-	  } else if (cmd != 0) {
+	  } else if (cmd != NULL) {
 	    inst->clientData = cmd;
 	  } else {	  
 	    inst->clientData = NULL;
@@ -438,16 +536,15 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
 	  
 	  if (strncmp(ObjStr(inst->argv[0]), "::nsf::methods::", 16) == 0) {
 	    cmd = Tcl_GetCommandFromObj(interp, inst->argv[0]);
-	    if (cmd != 0) {
+	    if (cmd != NULL) {
 	      //fprintf(stderr, "%s: asmMethodSelfCmdDispatch cmd '%s' => %p\n", procName, ObjStr(inst->argv[0]), cmd);
 	      AsmInstructionSetCmd(inst, asmMethodSelfCmdDispatch);
 	    }
 	  } else {
 	    //fprintf(stderr, "%s: asmMethodSelfDispatch cmd '%s'\n", procName, ObjStr(inst->argv[0]));
 	  }
-	  resInfo = NEW(AsmResolverInfo); // TODO: LEAK
+	  resInfo = AsmResolverInfoNew(proc);
 	  resInfo->cmd = cmd;
-	  resInfo->proc = proc;
 	  inst->clientData = resInfo;
 	}
       
@@ -468,6 +565,14 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       
       break;
 
+   case asmObjDispatchIdx:
+
+	inst = AsmInstructionNew(proc, asmObjDispatch, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = AsmResolverInfoNew(proc);
+      
+      break;
+
    case asmSelfIdx:
 
 	inst = AsmInstructionNew(proc, asmSelf, cArgs);
@@ -476,6 +581,22 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
 
       break;
 
+   case asmSelfDispatchIdx:
+
+	inst = AsmInstructionNew(proc, asmSelfDispatch, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = AsmResolverInfoNew(proc);
+      
+      break;
+
+   case asmSetInstVarIdx:
+
+	inst = AsmInstructionNew(proc, asmSetInstVar, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
    case asmSetIntIdx:
 
 	inst = AsmInstructionNew(proc, asmSetInt, cArgs);
@@ -484,6 +605,14 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
 
       break;
 
+   case asmSetIntSlotIdx:
+
+	inst = AsmInstructionNew(proc, asmSetIntSlot, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
    case asmSetObjIdx:
 
 	inst = AsmInstructionNew(proc, asmSetObj, cArgs);
@@ -540,6 +669,22 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
       
       break;
 
+   case asmUnboxIntIdx:
+
+	inst = AsmInstructionNew(proc, asmUnboxInt, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
+   case asmUnboxIntSlotIdx:
+
+	inst = AsmInstructionNew(proc, asmUnboxIntSlot, cArgs);
+	if (cArgs > 0) {AsmInstructionArgvSet(interp, offset, argc, 0, inst, proc, argv, 0);}
+	inst->clientData = proc;
+
+      break;
+
    case asmVarIdx:
 
 	proc->slots[currentSlot] = NULL;
@@ -566,13 +711,14 @@ AsmAssemble(ClientData cd, Tcl_Interp *interp, Tcl_Obj *nameObj,
    * from above.
    */
 
-  for (patchPtr = &patchArray[0]; patchPtr < patches; patchPtr++) {
-    fprintf(stderr, "wanna patch code[%d]->argv = code[%d]->argv[%d]\n",
-	    patchPtr->targetAsmInstruction, patchPtr->sourceAsmInstruction, patchPtr->argvIndex);
+  for (patchPtr = patchArray; patchPtr < patches; patchPtr++) {
+    /*fprintf(stderr, "patch code[%d]->argv = code[%d]->argv[%d]\n",
+      patchPtr->targetAsmInstruction, patchPtr->sourceAsmInstruction, patchPtr->argvIndex);*/
     /* set the argument vector of code[1] to the address of code[4]->argv[1] */
     (&proc->code[patchPtr->targetAsmInstruction])->argv = 
       &(&proc->code[patchPtr->sourceAsmInstruction])->argv[patchPtr->argvIndex];
   }
+  ckfree((char *)patchArray);
 
   *retAsmProc = proc;
 
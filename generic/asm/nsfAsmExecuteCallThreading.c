@@ -1,4 +1,21 @@
 
+static int asmBoxInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+
+	{
+	  int indexValue = PTR2INT(argv[0]);
+	  Tcl_Obj *valueObj = Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(argv[1])]));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+        return TCL_OK;
+}
+
 static int asmEval(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   int result;
 
@@ -22,56 +39,103 @@ static int asmDuplicateObj(ClientData clientData, Tcl_Interp *interp, int argc,
         return TCL_OK;
 }
 
+static int asmDuplicateResult(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+
+	{
+	  int indexValue = PTR2INT(argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(Tcl_GetObjResult(interp));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+        return TCL_OK;
+}
+
+static int asmDuplicateSlot(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+
+	{
+	  int indexValue = PTR2INT(argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(proc->slots[PTR2INT(argv[1])]);
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+        return TCL_OK;
+}
+
+static int asmGetInstVar(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+  int result;
+
+	{
+	  int indexValue = PTR2INT(argv[0]);
+	  Tcl_Obj *valueObj = Nsf_ObjGetVar2((Nsf_Object *)proc->currentObject, interp,
+					     argv[1], NULL, TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    valueObj = Tcl_DuplicateObj(valueObj);
+	    Tcl_IncrRefCount(valueObj);
+	    if (proc->slots[indexValue]) {
+	      Tcl_DecrRefCount(proc->slots[indexValue]);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+        return result;
+}
+
 static int asmIncrInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
+  int result;
 
 	{
-	  int intValue, incrValue;
+	  long longValue;
 	  //fprintf(stderr, "incrInt var[%d] incr var[%d]\n", PTR2INT(argv[0]), PTR2INT(argv[1]));
-	  intValue  = PTR2INT(proc->slots[PTR2INT(argv[0])]);
-	  incrValue = PTR2INT(proc->slots[PTR2INT(argv[1])]);
-	  //fprintf(stderr, ".... intValue %d incr Value %d\n", intValue, incrValue);
-	  
-	  proc->slots[PTR2INT(argv[0])] = INT2PTR(intValue + incrValue);
-	  //fprintf(stderr, ".... [%d] => %d\n", PTR2INT(argv[0]), intValue + incrValue);
+	  result = AsmLongAdd(interp,
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(argv[0])]),
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(argv[1])]),
+			      &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
 	}
-        return TCL_OK;
+        return result;
 }
 
 static int asmIncrObj(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
+  int result;
 
 	{
-	  int intValue, incrValue;
-	  Tcl_Obj *intObj, *incrObj;
-	  
+	  int indexValue = PTR2INT(argv[0]);
+	  Tcl_Obj *intObj = proc->slots[indexValue], *valueObj;
+
 	  //fprintf(stderr, "asmIncrScalar var[%d] incr var[%d], ", PTR2INT(argv[0]), PTR2INT(argv[1]));
-	  
-	  intObj = proc->slots[PTR2INT(argv[0])];
-	  incrObj = proc->slots[PTR2INT(argv[1])];
-	  
-	  if (likely(intObj->typePtr == Nsf_OT_intType)) {
-	    intValue = intObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, intObj, &intValue);
-	  }
-	  
-	  if (likely(incrObj->typePtr == Nsf_OT_intType)) {
-	    incrValue = incrObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, incrObj, &incrValue);
+
+	  result = AsmObjIncr(interp, intObj, proc->slots[PTR2INT(argv[1])], &valueObj);
+	  if (likely(result == TCL_OK) && valueObj != intObj) {
+	    Tcl_IncrRefCount(valueObj);
+	    if ((proc->slotFlags[indexValue] & ASM_SLOT_MUST_DECR) != 0) {
+	      Tcl_DecrRefCount(intObj);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
 	  }
-	  
-	  //fprintf(stderr, "%d + %d = %d,", intValue, incrValue, intValue + incrValue);
-	  
-	  Tcl_InvalidateStringRep(intObj);
-	  intObj->internalRep.longValue = (long)(intValue + incrValue);
-	  
-	  //fprintf(stderr, "updated %p var[%d] %p\n",  intObj, PTR2INT(argv[0]), proc->slots[PTR2INT(argv[0])]);
-	  
-	  //Tcl_SetObjResult(interp, intObj);
 	}
-        return TCL_OK;
+        return result;
 }
 
 static int asmJump(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
@@ -99,9 +163,9 @@ static int asmLeInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj
   AsmCompiledProc *proc = clientData;
 
 	{
-	  int value1, value2;
-	  value1 = PTR2INT(proc->slots[PTR2INT(argv[0])]);
-	  value2 = PTR2INT(proc->slots[PTR2INT(argv[1])]);
+	  long value1, value2;
+	  value1 = ASM_SLOT_LONG(proc->slots[PTR2INT(argv[0])]);
+	  value2 = ASM_SLOT_LONG(proc->slots[PTR2INT(argv[1])]);
 	  proc->status = value1 <= value2;
 	}
         return TCL_OK;
@@ -109,30 +173,12 @@ static int asmLeInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj
 
 static int asmLeIntObj(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
+  int result;
 
-	{
-	  int value1, value2;
-	  Tcl_Obj *obj;
-	  //fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", argc, argv[0], argv[1]);
-	  
-	  // for the time being, we compare two int values
-	  obj = proc->slots[PTR2INT(argv[0])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value1 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value1);
-	  }
-	  obj = proc->slots[PTR2INT(argv[1])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value2 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value2);
-	  }
-	  //fprintf(stderr, "asmLeScalar oc %d op1 %d op2 %d => %d\n", argc, value1, value2, value1 <= value2);
-	  
-	  proc->status = value1 <= value2;
-	}
-        return TCL_OK;
+	//fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", argc, argv[0], argv[1]);
+	result = AsmObjLe(interp, proc->slots[PTR2INT(argv[0])], proc->slots[PTR2INT(argv[1])],
+			  &proc->status);
+        return result;
 }
 
 static int asmMethodDelegateDispatch(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
@@ -199,6 +245,22 @@ static int asmNoop(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj
   return TCL_OK;
 }
 
+static int asmObjDispatch(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  int result;
+
+	{
+	  AsmResolverInfo *resInfo = clientData;
+	  NsfObject *object;
+
+	  if (likely(GetObjectFromObj(interp, argv[0], &object) == TCL_OK)) {
+	    result = AsmDispatch(interp, resInfo, object, argc-1, argv+1);
+	  } else {
+	    result = Tcl_EvalObjv(interp, argc, argv, 0);
+	  }
+	}
+        return result;
+}
+
 static int asmSelf(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
 
@@ -206,6 +268,35 @@ static int asmSelf(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj
         return TCL_OK;
 }
 
+static int asmSelfDispatch(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  int result;
+
+	{
+	  AsmResolverInfo *resInfo = clientData;
+	  result = AsmDispatch(interp, resInfo, resInfo->proc->currentObject, argc, argv);
+	}
+        return result;
+}
+
+static int asmSetInstVar(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+  int result;
+
+	{
+	  Tcl_Obj *valueObj = Nsf_ObjSetVar2((Nsf_Object *)proc->currentObject, interp,
+					     argv[0], NULL,
+					     Tcl_DuplicateObj(proc->slots[PTR2INT(argv[1])]),
+					     TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    Tcl_SetObjResult(interp, valueObj);
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+        return result;
+}
+
 static int asmSetInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
 
@@ -213,6 +304,13 @@ static int asmSetInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Ob
         return TCL_OK;
 }
 
+static int asmSetIntSlot(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+
+	proc->slots[PTR2INT(argv[0])] = proc->slots[PTR2INT(argv[1])];
+        return TCL_OK;
+}
+
 static int asmSetObj(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
 
@@ -239,7 +337,7 @@ static int asmSetResult(ClientData clientData, Tcl_Interp *interp, int argc, Tcl
 static int asmSetResultInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
   AsmCompiledProc *proc = clientData;
 
-	Tcl_SetObjResult(interp, Tcl_NewIntObj(PTR2INT(proc->slots[PTR2INT(argv[0])])));
+	Tcl_SetObjResult(interp, Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(argv[0])])));
         return TCL_OK;
 }
 
@@ -250,6 +348,36 @@ static int asmStoreResult(ClientData clientData, Tcl_Interp *interp, int argc, T
         return TCL_OK;
 }
 
+static int asmUnboxInt(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+  int result;
+
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, argv[1], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+        return result;
+}
+
+static int asmUnboxIntSlot(ClientData clientData, Tcl_Interp *interp, int argc, Tcl_Obj *argv[]) {
+  AsmCompiledProc *proc = clientData;
+  int result;
+
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, proc->slots[PTR2INT(argv[1])], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+        return result;
+}
+
 ;
 
 /*
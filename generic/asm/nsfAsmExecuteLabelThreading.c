@@ -1,8 +1,12 @@
 
 enum instructionIdx { 
   IDX_objProc,
+  IDX_asmBoxInt,
   IDX_asmEval,
   IDX_asmDuplicateObj,
+  IDX_asmDuplicateResult,
+  IDX_asmDuplicateSlot,
+  IDX_asmGetInstVar,
   IDX_asmIncrInt,
   IDX_asmIncrObj,
   IDX_asmJump,
@@ -14,13 +18,19 @@ enum instructionIdx {
   IDX_asmMethodSelfCmdDispatch,
   IDX_asmMethodSelfDispatch,
   IDX_asmNoop,
+  IDX_asmObjDispatch,
   IDX_asmSelf,
+  IDX_asmSelfDispatch,
+  IDX_asmSetInstVar,
   IDX_asmSetInt,
+  IDX_asmSetIntSlot,
   IDX_asmSetObj,
   IDX_asmSetObjToResult,
   IDX_asmSetResult,
   IDX_asmSetResultInt,
   IDX_asmStoreResult,
+  IDX_asmUnboxInt,
+  IDX_asmUnboxIntSlot,
   IDX_NULL
 };
 
@@ -38,8 +48,12 @@ int AsmExecute(ClientData cd, Tcl_Interp *interp, AsmCompiledProc *proc, int arg
 
   static void *instructionLabel[] = { 
     &&INST_objProc,
+    &&INST_asmBoxInt,
     &&INST_asmEval,
     &&INST_asmDuplicateObj,
+    &&INST_asmDuplicateResult,
+    &&INST_asmDuplicateSlot,
+    &&INST_asmGetInstVar,
     &&INST_asmIncrInt,
     &&INST_asmIncrObj,
     &&INST_asmJump,
@@ -51,13 +65,19 @@ int AsmExecute(ClientData cd, Tcl_Interp *interp, AsmCompiledProc *proc, int arg
     &&INST_asmMethodSelfCmdDispatch,
     &&INST_asmMethodSelfDispatch,
     &&INST_asmNoop,
+    &&INST_asmObjDispatch,
     &&INST_asmSelf,
+    &&INST_asmSelfDispatch,
+    &&INST_asmSetInstVar,
     &&INST_asmSetInt,
+    &&INST_asmSetIntSlot,
     &&INST_asmSetObj,
     &&INST_asmSetObjToResult,
     &&INST_asmSetResult,
     &&INST_asmSetResultInt,
     &&INST_asmStoreResult,
+    &&INST_asmUnboxInt,
+    &&INST_asmUnboxIntSlot,
     &&INST_NULL
   };
 
@@ -101,7 +121,24 @@ int AsmExecute(ClientData cd, Tcl_Interp *interp, AsmCompiledProc *proc, int arg
   result = (*ip->cmd)(ip->clientData, interp, ip->argc, ip->argv);
   goto EXEC_RESULT_CODE_HANDLER;
   
-  INST_asmEval:
+  INST_asmBoxInt:
+
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
+INST_asmEval:
 
 	result = Tcl_EvalObjv(interp, ip->argc, ip->argv, 0);
         goto EXEC_RESULT_CODE_HANDLER;
@@ -125,55 +162,102 @@ INST_asmDuplicateObj:
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
+INST_asmDuplicateResult:
+
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(Tcl_GetObjResult(interp));
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
+INST_asmDuplicateSlot:
+
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Tcl_DuplicateObj(proc->slots[PTR2INT(ip->argv[1])]);
+
+	  Tcl_IncrRefCount(valueObj);
+	  if (proc->slots[indexValue]) {
+	    Tcl_DecrRefCount(proc->slots[indexValue]);
+	  }
+	  proc->slots[indexValue] = valueObj;
+	  proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	}
+      
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
+INST_asmGetInstVar:
+
+	{
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *valueObj = Nsf_ObjGetVar2((Nsf_Object *)proc->currentObject, interp,
+					     ip->argv[1], NULL, TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    valueObj = Tcl_DuplicateObj(valueObj);
+	    Tcl_IncrRefCount(valueObj);
+	    if (proc->slots[indexValue]) {
+	      Tcl_DecrRefCount(proc->slots[indexValue]);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
 INST_asmIncrInt:
 
 	{
-	  int intValue, incrValue;
+	  long longValue;
 	  //fprintf(stderr, "incrInt var[%d] incr var[%d]\n", PTR2INT(ip->argv[0]), PTR2INT(ip->argv[1]));
-	  intValue  = PTR2INT(proc->slots[PTR2INT(ip->argv[0])]);
-	  incrValue = PTR2INT(proc->slots[PTR2INT(ip->argv[1])]);
-	  //fprintf(stderr, ".... intValue %d incr Value %d\n", intValue, incrValue);
-	  
-	  proc->slots[PTR2INT(ip->argv[0])] = INT2PTR(intValue + incrValue);
-	  //fprintf(stderr, ".... [%d] => %d\n", PTR2INT(ip->argv[0]), intValue + incrValue);
+	  result = AsmLongAdd(interp,
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])]),
+			      ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]),
+			      &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
 	}
-      
+        goto EXEC_RESULT_CODE_HANDLER;
+
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
 INST_asmIncrObj:
 
 	{
-	  int intValue, incrValue;
-	  Tcl_Obj *intObj, *incrObj;
-	  
+	  int indexValue = PTR2INT(ip->argv[0]);
+	  Tcl_Obj *intObj = proc->slots[indexValue], *valueObj;
+
 	  //fprintf(stderr, "asmIncrScalar var[%d] incr var[%d], ", PTR2INT(ip->argv[0]), PTR2INT(ip->argv[1]));
-	  
-	  intObj = proc->slots[PTR2INT(ip->argv[0])];
-	  incrObj = proc->slots[PTR2INT(ip->argv[1])];
-	  
-	  if (likely(intObj->typePtr == Nsf_OT_intType)) {
-	    intValue = intObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, intObj, &intValue);
-	  }
-	  
-	  if (likely(incrObj->typePtr == Nsf_OT_intType)) {
-	    incrValue = incrObj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, incrObj, &incrValue);
+
+	  result = AsmObjIncr(interp, intObj, proc->slots[PTR2INT(ip->argv[1])], &valueObj);
+	  if (likely(result == TCL_OK) && valueObj != intObj) {
+	    Tcl_IncrRefCount(valueObj);
+	    if ((proc->slotFlags[indexValue] & ASM_SLOT_MUST_DECR) != 0) {
+	      Tcl_DecrRefCount(intObj);
+	    }
+	    proc->slots[indexValue] = valueObj;
+	    proc->slotFlags[indexValue] |= ASM_SLOT_MUST_DECR;
 	  }
-	  
-	  //fprintf(stderr, "%d + %d = %d,", intValue, incrValue, intValue + incrValue);
-	  
-	  Tcl_InvalidateStringRep(intObj);
-	  intObj->internalRep.longValue = (long)(intValue + incrValue);
-	  
-	  //fprintf(stderr, "updated %p var[%d] %p\n",  intObj, PTR2INT(ip->argv[0]), proc->slots[PTR2INT(ip->argv[0])]);
-	  
-	  //Tcl_SetObjResult(interp, intObj);
 	}
-      
+        goto EXEC_RESULT_CODE_HANDLER;
+
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
@@ -199,9 +283,9 @@ INST_asmJumpTrue:
 INST_asmLeInt:
 
 	{
-	  int value1, value2;
-	  value1 = PTR2INT(proc->slots[PTR2INT(ip->argv[0])]);
-	  value2 = PTR2INT(proc->slots[PTR2INT(ip->argv[1])]);
+	  long value1, value2;
+	  value1 = ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])]);
+	  value2 = ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[1])]);
 	  proc->status = value1 <= value2;
 	}
       
@@ -210,29 +294,11 @@ INST_asmLeInt:
 
 INST_asmLeIntObj:
 
-	{
-	  int value1, value2;
-	  Tcl_Obj *obj;
-	  //fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", ip->argc, ip->argv[0], ip->argv[1]);
-	  
-	  // for the time being, we compare two int values
-	  obj = proc->slots[PTR2INT(ip->argv[0])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value1 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value1);
-	  }
-	  obj = proc->slots[PTR2INT(ip->argv[1])];
-	  if (likely(obj->typePtr == Nsf_OT_intType)) {
-	    value2 = obj->internalRep.longValue;
-	  } else {
-	    Tcl_GetIntFromObj(interp, obj, &value2);
-	  }
-	  //fprintf(stderr, "asmLeScalar oc %d op1 %d op2 %d => %d\n", ip->argc, value1, value2, value1 <= value2);
-	  
-	  proc->status = value1 <= value2;
-	}
-      
+	//fprintf(stderr, "leIntObj oc %d op1 %p op2 %p\n", ip->argc, ip->argv[0], ip->argv[1]);
+	result = AsmObjLe(interp, proc->slots[PTR2INT(ip->argv[0])], proc->slots[PTR2INT(ip->argv[1])],
+			  &proc->status);
+        goto EXEC_RESULT_CODE_HANDLER;
+
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
@@ -305,6 +371,23 @@ INST_asmNoop:
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
+INST_asmObjDispatch:
+
+	{
+	  AsmResolverInfo *resInfo = ip->clientData;
+	  NsfObject *object;
+
+	  if (likely(GetObjectFromObj(interp, ip->argv[0], &object) == TCL_OK)) {
+	    result = AsmDispatch(interp, resInfo, object, ip->argc-1, ip->argv+1);
+	  } else {
+	    result = Tcl_EvalObjv(interp, ip->argc, ip->argv, 0);
+	  }
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
 INST_asmSelf:
 
 	Tcl_SetObjResult(interp, proc->currentObject->cmdName);
@@ -312,6 +395,36 @@ INST_asmSelf:
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
+INST_asmSelfDispatch:
+
+	{
+	  AsmResolverInfo *resInfo = ip->clientData;
+	  result = AsmDispatch(interp, resInfo, resInfo->proc->currentObject, ip->argc, ip->argv);
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
+INST_asmSetInstVar:
+
+	{
+	  Tcl_Obj *valueObj = Nsf_ObjSetVar2((Nsf_Object *)proc->currentObject, interp,
+					     ip->argv[0], NULL,
+					     Tcl_DuplicateObj(proc->slots[PTR2INT(ip->argv[1])]),
+					     TCL_LEAVE_ERR_MSG);
+	  if (likely(valueObj != NULL)) {
+	    Tcl_SetObjResult(interp, valueObj);
+	    result = TCL_OK;
+	  } else {
+	    result = TCL_ERROR;
+	  }
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
 INST_asmSetInt:
 
 	proc->slots[PTR2INT(ip->argv[0])] = ip->argv[1];
@@ -319,6 +432,13 @@ INST_asmSetInt:
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
+INST_asmSetIntSlot:
+
+	proc->slots[PTR2INT(ip->argv[0])] = proc->slots[PTR2INT(ip->argv[1])];
+      
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
 INST_asmSetObj:
 
 	//fprintf(stderr, "setObj var[%d] = %s\n", PTR2INT(ip->argv[0]), ObjStr(ip->argv[1]));  
@@ -344,7 +464,7 @@ INST_asmSetResult:
 
 INST_asmSetResultInt:
 
-	Tcl_SetObjResult(interp, Tcl_NewIntObj(PTR2INT(proc->slots[PTR2INT(ip->argv[0])])));
+	Tcl_SetObjResult(interp, Tcl_NewLongObj(ASM_SLOT_LONG(proc->slots[PTR2INT(ip->argv[0])])));
       
   ip++;
   goto *instructionLabel[ip->labelIdx];
@@ -357,6 +477,36 @@ INST_asmStoreResult:
   ip++;
   goto *instructionLabel[ip->labelIdx];
 
+INST_asmUnboxInt:
+
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, ip->argv[1], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
+INST_asmUnboxIntSlot:
+
+	{
+	  long longValue;
+
+	  result = Tcl_GetLongFromObj(interp, proc->slots[PTR2INT(ip->argv[1])], &longValue);
+	  if (likely(result == TCL_OK)) {
+	    proc->slots[PTR2INT(ip->argv[0])] = ASM_LONG_SLOT(longValue);
+	  }
+	}
+        goto EXEC_RESULT_CODE_HANDLER;
+
+  ip++;
+  goto *instructionLabel[ip->labelIdx];
+
 
 }
 
@@ -7,7 +7,14 @@
  * Copyright (C) 2011-2014 Gustaf Neumann
  */
 
-//#define LABEL_THREADING
+/*
+ * Label threading relies on the "labels as values" extension of GCC
+ * (also provided by clang); use it, unless call threading was
+ * requested explicitly (configure flag --enable-assemble=call).
+ */
+#if defined(NSF_ASSEMBLE_LT) || (!defined(NSF_ASSEMBLE_CT) && (defined(__GNUC__) || defined(__clang__)))
+# define LABEL_THREADING
+#endif
 
 #if defined(LABEL_THREADING)
 typedef void (* InstLabel)();
@@ -20,6 +27,13 @@ typedef void (* InstLabel)();
 #define ASM_SLOT_MUST_DECR  0x0001
 #define ASM_SLOT_IS_INTEGER 0x0010
 
+/*
+ * Integer slots hold long values (the integer representation of Tcl
+ * objects), which fit into the pointer-sized slots.
+ */
+#define ASM_SLOT_LONG(slot)  ((long)(size_t)(slot))
+#define ASM_LONG_SLOT(value) ((Tcl_Obj *)(size_t)(value))
+
 typedef struct AsmStatementInfo {
   int flags;
   CONST char **argTypes;
@@ -43,20 +57,22 @@ typedef struct AsmArgReference {
   Tcl_Obj **objPtr;
 } AsmArgReference;
 
-#define NSF_ASM_NR_STATIC_SLOTS 30
 typedef struct AsmCompiledProc {
   struct AsmInstruction *ip;  /* pointer to the next writable instruction */
   struct AsmInstruction *code;
   NsfObject *currentObject;
   int status;
-  int nrLocals;
-  Tcl_Obj **firstObj;      /* pointer to staticObjs */
-  Tcl_Obj **locals;        /* pointer to staticObjs */
-  Tcl_Obj **slots;         /* pointer to staticObjs */
-  int slotFlags[NSF_ASM_NR_STATIC_SLOTS];       /* same size as allocated slots */
-  Tcl_Obj *staticObjs[NSF_ASM_NR_STATIC_SLOTS]; // static objs for the time being TODO overflows/dynamic
+  int active;              /* number of active invocations */
+  int nrLocals;            /* number of arguments and slots */
+  Tcl_Obj **objs;          /* locals, slots and instruction arguments */
+  Tcl_Obj **firstObj;      /* pointer to the first free element of objs */
+  Tcl_Obj **locals;        /* pointer into objs */
+  Tcl_Obj **slots;         /* pointer into objs */
+  int *slotFlags;          /* flags per slot, same size as slots */
+  Tcl_Obj *literalsObj;    /* list keeping the words referenced from instructions */
   int nrAsmArgReferences;
-  struct AsmArgReference argReferences[10]; // for the time being TODO overflows/dynamic
+  struct AsmArgReference *argReferences;
+  struct AsmResolverInfo *resolverInfos; /* resolver infos to be freed with the proc */
 } AsmCompiledProc;
 
 typedef struct AsmPatches {
@@ -71,12 +87,17 @@ typedef struct AsmProcClientData {
   NsfParamDefs *paramDefs;
   int with_ad;
   int with_checkAlways;
+  int refCount;        /* the cmd and every running invocation */
 } AsmProcClientData;
 
 typedef struct AsmResolverInfo {
   Tcl_Command cmd;
   NsfObject *object;
   AsmCompiledProc *proc;
+  NsfClass *receiverClass; /* inline cache of the dispatch instructions: */
+  NsfClass *cl;            /* receiver class, class of the method and */
+  int methodEpoch;         /* the instanceMethodEpoch of the lookup */
+  struct AsmResolverInfo *nextPtr;
 } AsmResolverInfo;
 
 #if defined(LABEL_THREADING)
@@ -121,6 +142,24 @@ void AsmArgSet(AsmCompiledProc *proc, int argNr, Tcl_Obj **addr) {
   proc->nrAsmArgReferences ++;
 }
 
+AsmResolverInfo *AsmResolverInfoNew(AsmCompiledProc *proc) {
+  AsmResolverInfo *resInfo = NEW(AsmResolverInfo);
+
+  resInfo->cmd = NULL;
+  resInfo->object = NULL;
+  resInfo->proc = proc;
+  resInfo->receiverClass = NULL;
+  resInfo->cl = NULL;
+  resInfo->methodEpoch = 0;
+  resInfo->nextPtr = proc->resolverInfos;
+  proc->resolverInfos = resInfo;
+  return resInfo;
+}
+
+void AsmLiteralKeep(AsmCompiledProc *proc, Tcl_Obj *obj) {
+  Tcl_ListObjAppendElement(NULL, proc->literalsObj, obj);
+}
+
 void AsmInstructionPrint(AsmInstruction *ip) {
   int i; 
   fprintf(stderr, "(%d) ", ip->argc);
@@ -129,6 +168,111 @@ void AsmInstructionPrint(AsmInstruction *ip) {
 }
 
 
+/*
+ *----------------------------------------------------------------------
+ * AsmDispatchCacheLookup --
+ *
+ *    Lookup the method called by a dispatch instruction via the
+ *    inline cache of the instruction. The cache keeps the cmd and the
+ *    class of the method found for the class of the receiver and is
+ *    valid as long as the instanceMethodEpoch is unchanged. It is
+ *    only used for receivers without per-object methods, mixins and
+ *    filters.
+ *
+ * Results:
+ *    Tcl_Command or NULL, when a full dispatch is needed; the class
+ *    of the method is returned in *clPtr.
+ *
+ * Side effects:
+ *    Updates the inline cache.
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Command
+AsmDispatchCacheLookup(Tcl_Interp *interp, AsmResolverInfo *resInfo, NsfObject *object,
+                       const char *methodName, NsfClass **clPtr) {
+  NsfRuntimeState *rst = RUNTIME_STATE(interp);
+
+  if (unlikely(object->nsPtr != NULL
+               || (object->flags & (NSF_MIXIN_ORDER_DEFINED_AND_VALID|NSF_FILTER_ORDER_DEFINED_AND_VALID))
+               != (NSF_MIXIN_ORDER_VALID|NSF_FILTER_ORDER_VALID))) {
+    return NULL;
+  }
+
+  if (likely(resInfo->receiverClass == object->cl
+             && resInfo->methodEpoch == rst->instanceMethodEpoch)) {
+    NSF_DISPATCH_STAT(rst, NSF_DISPATCH_ASM_CACHE_HIT);
+  } else {
+    NSF_DISPATCH_STAT(rst, NSF_DISPATCH_ASM_CACHE_MISS);
+    assert(object->cl->order != NULL);
+    resInfo->cmd = NULL;
+    resInfo->cl = SearchPLMethod(object->cl->order, methodName, &resInfo->cmd,
+                                 NSF_CMD_CALL_PRIVATE_METHOD);
+    resInfo->receiverClass = object->cl;
+    resInfo->methodEpoch = rst->instanceMethodEpoch;
+  }
+  *clPtr = resInfo->cl;
+  return resInfo->cmd;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmDispatch --
+ *
+ *    Call a method from a dispatch instruction. The first element of
+ *    objv is the method name. When the method is found in the inline
+ *    cache, it is called directly via MethodDispatch(), otherwise via
+ *    ObjectDispatch(), which handles per-object methods, mixins,
+ *    filters and unknown methods.
+ *
+ * Results:
+ *    Tcl result code.
+ *
+ * Side effects:
+ *    Indirect effects by calling methods.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+AsmDispatch(Tcl_Interp *interp, AsmResolverInfo *resInfo, NsfObject *object,
+            int objc, Tcl_Obj *CONST objv[]) {
+  const char *methodName = ObjStr(objv[0]);
+  Tcl_Command cmd;
+  NsfClass *cl;
+  int result;
+
+  cmd = AsmDispatchCacheLookup(interp, resInfo, object, methodName, &cl);
+
+  if (likely(cmd != NULL
+             && (object == resInfo->proc->currentObject
+                 || (Tcl_Command_flags(cmd) & NSF_CMD_CALL_PROTECTED_METHOD) == 0))) {
+    Tcl_Obj *cmdName = object->cmdName;
+
+    /*
+     * Make sure, cmdName and object survive the call (as in
+     * ObjectDispatch()). The asm engine is not NRE-aware, therefore
+     * the method has to be executed immediately.
+     */
+    INCR_REF_COUNT(cmdName);
+    NsfObjectRefCountIncr(object);
+
+    result = MethodDispatch(object, interp, objc, objv, cmd, object, cl,
+                            methodName, NSF_CSC_TYPE_PLAIN, NSF_CSC_IMMEDIATE);
+    if (unlikely(result == TCL_ERROR)) {
+      result = NsfErrInProc(interp, cmdName,
+                            (cl != NULL && cl->object.teardown != NULL) ? cl->object.cmdName : NULL,
+                            methodName);
+    }
+
+    NsfCleanupObject(object, "AsmDispatch");
+    DECR_REF_COUNT(cmdName);
+  } else {
+    result = ObjectDispatch(object, interp, objc, objv, NSF_CM_NO_SHIFT|NSF_CSC_IMMEDIATE);
+  }
+
+  return result;
+}
+
 /*
  *----------------------------------------------------------------------
  * AsmExecute, AsmAssemble --
@@ -152,6 +296,157 @@ AsmInstructionArgvSet(Tcl_Interp *interp, int from, int to, int currentArg,
 	       AsmInstruction *inst, AsmCompiledProc *asmProc,
 	       Tcl_Obj **wordOv, int verbose);
 
+/*
+ *----------------------------------------------------------------------
+ * AsmObjIsLong --
+ *
+ *    Check, whether an object slot holds an integer fitting into a
+ *    long. In contrast to Tcl_GetLongFromObj(), bignums in the range
+ *    of an unsigned long are not wrapped around.
+ *
+ * Results:
+ *    1 when the value is a long (returned in *longPtr), 0 otherwise.
+ *
+ * Side effects:
+ *    Might convert the object to an integer.
+ *
+ *----------------------------------------------------------------------
+ */
+static NSF_INLINE int
+AsmObjIsLong(Tcl_Obj *obj, long *longPtr) {
+
+  if (likely(obj->typePtr == Nsf_OT_intType)) {
+    *longPtr = obj->internalRep.longValue;
+    return 1;
+  }
+  return (Tcl_GetLongFromObj(NULL, obj, longPtr) == TCL_OK
+          && obj->typePtr == Nsf_OT_intType);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmObjLe --
+ *
+ *    Compare the values of two object slots like the "<=" operator of
+ *    expr. Integers fitting into a long are compared directly, all
+ *    other values (bignums, floating point numbers, strings) are
+ *    compared by ::tcl::mathop::<=.
+ *
+ * Results:
+ *    Tcl result code, the outcome of the comparison in *lePtr.
+ *
+ * Side effects:
+ *    Might convert the objects to numbers.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+AsmObjLe(Tcl_Interp *interp, Tcl_Obj *obj1, Tcl_Obj *obj2, int *lePtr) {
+  long value1, value2;
+  Tcl_Obj *ov[3];
+  int result;
+
+  if (likely(AsmObjIsLong(obj1, &value1) && AsmObjIsLong(obj2, &value2))) {
+    *lePtr = value1 <= value2;
+    return TCL_OK;
+  }
+
+  ov[0] = Tcl_NewStringObj("::tcl::mathop::<=", -1);
+  ov[1] = obj1;
+  ov[2] = obj2;
+  INCR_REF_COUNT(ov[0]);
+  result = Tcl_EvalObjv(interp, 3, ov, TCL_EVAL_GLOBAL);
+  DECR_REF_COUNT(ov[0]);
+  if (likely(result == TCL_OK)) {
+    result = Tcl_GetBooleanFromObj(interp, Tcl_GetObjResult(interp), lePtr);
+    Tcl_ResetResult(interp);
+  }
+  return result;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmObjIncr --
+ *
+ *    Add the value of incrObj to the value of obj like incr. Longs
+ *    are added without a call to Tcl, when the sum does not fit into
+ *    a long or one of the values is a bignum, the sum is a bignum.
+ *    Unshared objects are modified in place.
+ *
+ * Results:
+ *    Tcl result code, the object holding the sum in *sumObjPtr (obj
+ *    or a new object with a reference count of 0).
+ *
+ * Side effects:
+ *    Might modify obj.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+AsmObjIncr(Tcl_Interp *interp, Tcl_Obj *obj, Tcl_Obj *incrObj, Tcl_Obj **sumObjPtr) {
+  long value, incrValue;
+  mp_int bigValue, bigIncrValue;
+
+  if (likely(AsmObjIsLong(obj, &value) && AsmObjIsLong(incrObj, &incrValue)
+             && !((incrValue > 0 && value > LONG_MAX - incrValue)
+                  || (incrValue < 0 && value < LONG_MIN - incrValue)))) {
+    if (likely(!Tcl_IsShared(obj))) {
+      Tcl_SetLongObj(obj, value + incrValue);
+      *sumObjPtr = obj;
+    } else {
+      *sumObjPtr = Tcl_NewLongObj(value + incrValue);
+    }
+    return TCL_OK;
+  }
+
+  if (Tcl_GetBignumFromObj(interp, obj, &bigValue) != TCL_OK) {
+    return TCL_ERROR;
+  }
+  if (Tcl_GetBignumFromObj(interp, incrObj, &bigIncrValue) != TCL_OK) {
+    mp_clear(&bigValue);
+    return TCL_ERROR;
+  }
+  mp_add(&bigValue, &bigIncrValue, &bigValue);
+  mp_clear(&bigIncrValue);
+  if (!Tcl_IsShared(obj)) {
+    Tcl_SetBignumObj(obj, &bigValue);
+    *sumObjPtr = obj;
+  } else {
+    *sumObjPtr = Tcl_NewBignumObj(&bigValue);
+  }
+  return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmLongAdd --
+ *
+ *    Add two integer slots of the asm engine. Tcl would continue with
+ *    a bignum when the sum does not fit into a long. Integer slots are
+ *    only incremented by constants in the range of an int (with
+ *    64-bit longs, this takes more than 2^32 increments); the asm
+ *    engine reports an error instead of wrapping around.
+ *
+ * Results:
+ *    Tcl result code, the sum in *sumPtr.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------
+ */
+static NSF_INLINE int
+AsmLongAdd(Tcl_Interp *interp, long value, long incrValue, long *sumPtr) {
+
+  if (unlikely((incrValue > 0 && value > LONG_MAX - incrValue)
+               || (incrValue < 0 && value < LONG_MIN - incrValue))) {
+    return NsfPrintError(interp, "integer overflow: %ld + %ld does not fit into a long",
+                         value, incrValue);
+  }
+  *sumPtr = value + incrValue;
+  return TCL_OK;
+}
+
 #if defined(LABEL_THREADING)
 # include "asm/nsfAsmExecuteLabelThreading.c"
 #else
@@ -193,8 +488,9 @@ AsmInstructionArgvCheck(Tcl_Interp *interp, int from, int to, CONST char **argTy
 			   ObjStr(wordOv[j]), ObjStr(lineObj));
     }
     //fprintf(stderr, "check arg value %s\n", ObjStr(wordOv[j+1]));
-    if (Tcl_GetIntFromObj(interp, wordOv[j+1], &intValue) != TCL_OK 
-	|| intValue < 0) {
+    /* "int" denotes an integer value, all other types denote indices */
+    if (Tcl_GetIntFromObj(interp, wordOv[j+1], &intValue) != TCL_OK
+	|| (intValue < 0 && typesIndex != asmStatementArgTypeIntIdx)) {
       return NsfPrintError(interp, 
 			   "Asm: instruction argument of type %s must have numeric index >= 0,"
 			   " got '%s', line '%s'", 
@@ -205,7 +501,7 @@ AsmInstructionArgvCheck(Tcl_Interp *interp, int from, int to, CONST char **argTy
 	 typesIndex == asmStatementArgTypeObjIdx || 
 	 typesIndex == asmStatementArgTypeSlotIdx
 	 )
-	&& intValue > nrSlots) {
+	&& intValue >= nrSlots) {
       return NsfPrintError(interp, 
 			   "Asm: instruction argument value must be less than %d,"
 			   " got '%s', line '%s'", 
@@ -270,9 +566,8 @@ AsmInstructionArgvSet(Tcl_Interp *interp, int from, int to, int currentArg,
       break;
 
     case asmStatementArgTypeVarIdx:
-      fprintf(stderr, ".... var set [%d] = %s\n", currentArg, ObjStr(wordOv[j+1]));
       inst->argv[currentArg] = wordOv[j+1];
-      Tcl_IncrRefCount(inst->argv[currentArg]); // TODO: DECR missing
+      AsmLiteralKeep(asmProc, wordOv[j+1]);
       break;
 
     }
@@ -282,35 +577,211 @@ AsmInstructionArgvSet(Tcl_Interp *interp, int from, int to, int currentArg,
   }
 }
 
+/*
+ *----------------------------------------------------------------------
+ * AsmCompiledProcFree --
+ *
+ *    Free an assembled proc together with the objects owned by its
+ *    slots, its literals and the resolver infos of its instructions.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    Frees memory.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+AsmCompiledProcFree(AsmCompiledProc *proc) {
+  AsmResolverInfo *resInfo, *nextPtr;
+  int i, nrSlots = proc->nrLocals - (int)(proc->slots - proc->locals);
+
+  for (i = 0; i < nrSlots; i++) {
+    if ((proc->slotFlags[i] & ASM_SLOT_MUST_DECR) != 0 && proc->slots[i] != NULL) {
+      DECR_REF_COUNT(proc->slots[i]);
+    }
+  }
+  for (resInfo = proc->resolverInfos; resInfo != NULL; resInfo = nextPtr) {
+    nextPtr = resInfo->nextPtr;
+    FREE(AsmResolverInfo, resInfo);
+  }
+  DECR_REF_COUNT(proc->literalsObj);
+
+  ckfree((char *)proc->argReferences);
+  ckfree((char *)proc->slotFlags);
+  ckfree((char *)proc->objs);
+  ckfree((char *)proc->code);
+  ckfree((char *)proc);
+}
 
+/*
+ *----------------------------------------------------------------------
+ * AsmParamDefsCheck --
+ *
+ *    Check, whether the parameter definitions can be handled by the
+ *    asm engine, which addresses arguments positionally. Supported
+ *    are required positional parameters without a type or with the
+ *    types "integer" or "int32". When typesObj is not NULL, the
+ *    type of the slot receiving the argument ("int" or "obj") is
+ *    appended to it for every parameter. Only "int32" arguments are
+ *    loaded into integer slots, "integer" accepts bignums as well.
+ *
+ * Results:
+ *    Tcl result code.
+ *
+ * Side effects:
+ *    Might append to typesObj.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+AsmParamDefsCheck(Tcl_Interp *interp, Tcl_Obj *nameObj, NsfParamDefs *paramDefs, Tcl_Obj *typesObj) {
+  Nsf_Param const *paramPtr;
+
+  for (paramPtr = paramDefs->paramsPtr; paramPtr->name != NULL; paramPtr++) {
+    const char *type;
+
+    if (*paramPtr->name == '-'
+        || (paramPtr->flags & NSF_ARG_REQUIRED) == 0
+        || (paramPtr->flags & ~(NSF_ARG_REQUIRED|NSF_ARG_CHECK_NONPOS)) != 0) {
+      type = NULL;
+    } else if (paramPtr->converter == Nsf_ConvertToInt32) {
+      type = "int";
+    } else if (paramPtr->converter == Nsf_ConvertToInteger
+               || (paramPtr->converter == Nsf_ConvertToTclobj && paramPtr->converterArg == NULL)) {
+      type = "obj";
+    } else {
+      type = NULL;
+    }
+    if (type == NULL) {
+      return NsfPrintError(interp, "asm proc %s: unsupported parameter '%s'",
+                           ObjStr(nameObj), ObjStr(paramPtr->paramObj));
+    }
+    if (typesObj != NULL) {
+      Tcl_ListObjAppendElement(interp, typesObj, Tcl_NewStringObj(type, -1));
+    }
+  }
+  return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmProcClientDataRelease --
+ *
+ *    Release a reference to the client data of an asm proc. The
+ *    command holds one reference, every running invocation another
+ *    one (like Tcl preserves a Proc during its execution), such that
+ *    a method redefined or deleted while it runs is freed when the
+ *    last invocation returns.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    Frees the client data and the compiled proc with the last
+ *    reference.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+AsmProcClientDataRelease(AsmProcClientData *cd) {
+
+  if (--cd->refCount > 0) {
+    return;
+  }
+  assert(cd->proc->active == 0);
+  AsmCompiledProcFree(cd->proc);
+  if (cd->paramDefs != NULL) {
+    ParamDefsRefCountDecr(cd->paramDefs);
+  }
+  FREE(AsmProcClientData, cd);
+}
 
 /*
  *----------------------------------------------------------------------
  * NsfAsmProcDeleteProc --
  *
  *    Tcl_CmdDeleteProc for NsfAsmProcDeleteProc. Is called, whenever a
- *    NsfAsmProcDeleteProc is deleted and frees the associated client data.
+ *    NsfAsmProcDeleteProc is deleted and releases the associated
+ *    client data.
  *
  * Results:
  *    None.
  *
  * Side effects:
- *    Frees client-data
+ *    Might free client-data
  *
  *----------------------------------------------------------------------
  */
 static void
 NsfAsmProcDeleteProc(ClientData clientData) {
-  AsmProcClientData *cd = clientData;
 
   /*fprintf(stderr, "NsfAsmProcDeleteProc received %p\n", clientData);*/
-  
-  fprintf(stderr, "NsfAsmProcDeleteProc: TODO free asmProc\n");
-  if (cd->paramDefs != 0) {
-    /* tcd->paramDefs is freed by NsfProcDeleteProc() */
-    fprintf(stderr, "NsfAsmProcDeleteProc: TODO free paramDefs\n");
+
+  AsmProcClientDataRelease((AsmProcClientData *)clientData);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * AsmExecuteNested --
+ *
+ *    Execute an asm proc, which is already active (recursive or
+ *    mutually recursive calls). The execution state (arguments,
+ *    slots, patched instruction arguments, instruction pointer, status
+ *    and current object) lives in the proc structure; the state of the
+ *    active invocation is saved before and restored after the nested
+ *    execution. The saved copy holds an own reference to every object
+ *    owned by a slot.
+ *
+ * Results:
+ *    Tcl result code.
+ *
+ * Side effects:
+ *    Releases the objects left in the slots by the nested execution.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+AsmExecuteNested(Tcl_Interp *interp, AsmCompiledProc *proc, NsfObject *object,
+                 int objc, Tcl_Obj *CONST objv[]) {
+  int i, result, status = proc->status;
+  int nrObjs = (int)(proc->firstObj - proc->objs);
+  int nrSlots = proc->nrLocals - (int)(proc->slots - proc->locals);
+  AsmInstruction *ip = proc->ip;
+  NsfObject *currentObject = proc->currentObject;
+  Tcl_Obj **savedObjs;
+  int *savedSlotFlags;
+
+  savedObjs = (Tcl_Obj **)ckalloc(sizeof(Tcl_Obj *) * (nrObjs + 1));
+  savedSlotFlags = (int *)ckalloc(sizeof(int) * (nrSlots + 1));
+  memcpy(savedObjs, proc->objs, sizeof(Tcl_Obj *) * nrObjs);
+  memcpy(savedSlotFlags, proc->slotFlags, sizeof(int) * nrSlots);
+
+  for (i = 0; i < nrSlots; i++) {
+    if ((proc->slotFlags[i] & ASM_SLOT_MUST_DECR) != 0 && proc->slots[i] != NULL) {
+      INCR_REF_COUNT(proc->slots[i]);
+    }
   }
-  FREE(AsmProcClientData, cd);
+
+  proc->currentObject = object;
+  result = AsmExecute(NULL, interp, proc, objc, objv);
+
+  for (i = 0; i < nrSlots; i++) {
+    if ((proc->slotFlags[i] & ASM_SLOT_MUST_DECR) != 0 && proc->slots[i] != NULL) {
+      DECR_REF_COUNT(proc->slots[i]);
+    }
+  }
+  memcpy(proc->objs, savedObjs, sizeof(Tcl_Obj *) * nrObjs);
+  memcpy(proc->slotFlags, savedSlotFlags, sizeof(int) * nrSlots);
+  proc->ip = ip;
+  proc->status = status;
+  proc->currentObject = currentObject;
+
+  ckfree((char *)savedSlotFlags);
+  ckfree((char *)savedObjs);
+
+  return result;
 }
 
 /*
@@ -338,52 +809,67 @@ NsfAsmProc(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST o
   assert(cd->proc);
   //fprintf(stderr, "NsfAsmProcStub %s is called, tcd %p object %p\n", ObjStr(objv[0]), cd, cd->object);
 
-  if (likely(cd->paramDefs && cd->paramDefs->paramsPtr)) {
-    ALLOC_ON_STACK(Tcl_Obj*, objc, tov);
-
-    fprintf(stderr, "not implemented yet\n");
-#if 0
-    {
-      ParseContext *pcPtr;
-      pcPtr = (ParseContext *) NsfTclStackAlloc(interp, sizeof(ParseContext), "parse context");
-      /*
-       * We have to substitute the first element of objv with the name
-       * of the function to be called. Since objv is immutable, we have
-       * to copy the full argument vector and replace the element on
-       * position [0]
-       */
-      memcpy(tov, objv, sizeof(Tcl_Obj *)*(objc));
-      //tov[0] = tcd->procName;
-      
-      /* If the argument parsing is ok, the body will be called */
-      result = ProcessMethodArguments(pcPtr, interp, NULL, 0,
-				      cd->paramDefs, objv[0],
-				      objc, tov);
-      
-      if (likely(result == TCL_OK)) {
-	result = InvokeShadowedProc(interp, cd->procName, cd->cmd, pcPtr);
-      } else {
-	/*Tcl_Obj *resultObj = Tcl_GetObjResult(interp);
-	  fprintf(stderr, "NsfProcStub: incorrect arguments (%s)\n", ObjStr(resultObj));*/
-	ParseContextRelease(pcPtr);
-	NsfTclStackFree(interp, pcPtr, "release parse context");
-      }
-    }
-#endif
-    /*fprintf(stderr, "NsfProcStub free on stack %p\n", tov);*/
-    FREE_ON_STACK(Tcl_Obj *, tov);
-
-  } else {
+  {
     int requiredArgs = cd->proc->slots - cd->proc->locals;
 
-    //fprintf(stderr, "no compiled parameters\n");
     if (unlikely(requiredArgs != objc-1)) {
+      if (cd->paramDefs != NULL) {
+        /*
+         * Report like ArgumentParse() for the Tcl methods.
+         */
+        Nsf_Param const *paramsPtr = cd->paramDefs->paramsPtr;
+
+        if (objc-1 > requiredArgs) {
+          return NsfUnexpectedArgumentError(interp, ObjStr(objv[requiredArgs+1]),
+                                            (Nsf_Object *)cd->object, paramsPtr, objv[0]);
+        } else {
+          Tcl_Obj *paramDefsObj = NsfParamDefsSyntax(interp, paramsPtr, cd->object, NULL);
+
+          NsfPrintError(interp, "required argument '%s' is missing, should be:\n\t%s%s%s %s",
+                        paramsPtr[objc-1].name,
+                        (cd->object != NULL) ? ObjectName(cd->object) : "",
+                        (cd->object != NULL) ? " " : "",
+                        ObjStr(objv[0]), ObjStr(paramDefsObj));
+          DECR_REF_COUNT2("paramDefsObj", paramDefsObj);
+          return TCL_ERROR;
+        }
+      }
       return NsfPrintError(interp, "wrong # of arguments");
     }
+  }
+
+  if (cd->paramDefs != NULL) {
+    Nsf_Param const *paramPtr;
+    int i;
+
+    /*
+     * Asm methods have only positional parameters (see
+     * AsmParamDefsCheck()); check the values of the typed ones. The
+     * code loads such values into unboxed slots (e.g. via unboxInt).
+     */
+    for (i = 1, paramPtr = cd->paramDefs->paramsPtr; i < objc; i++, paramPtr++) {
+      if (paramPtr->converter != Nsf_ConvertToTclobj) {
+        ClientData checkedData;
+        Tcl_Obj *outObjPtr = objv[i];
+
+        result = (*paramPtr->converter)(interp, objv[i], paramPtr, &checkedData, &outObjPtr);
+        if (unlikely(result != TCL_OK)) {
+          return result;
+        }
+      }
+    }
+  }
+
+  cd->refCount++;
+  cd->proc->active++;
+  if (likely(cd->proc->active == 1)) {
     cd->proc->currentObject = cd->object;
     result = AsmExecute(NULL, interp, cd->proc, objc, objv);
-  
+  } else {
+    result = AsmExecuteNested(interp, cd->proc, cd->object, objc, objv);
   }
+  cd->proc->active--;
+  AsmProcClientDataRelease(cd);
 
   return result;
 }
@@ -393,11 +879,16 @@ NsfAsmProc(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST o
 
 static int
 NsfAsmProcAddParam(Tcl_Interp *interp, NsfParsedParam *parsedParamPtr,
-		   Tcl_Obj *nameObj, Tcl_Obj *bodyObj, int with_ad) {
-  fprintf(stderr, "NsfAsmProcAddParam not implemented yet\n");
-  //CONST char *procName = ObjStr(nameObj);
-
-  return TCL_OK;
+		   Tcl_Obj *nameObj, Tcl_Obj *bodyObj, int with_ad, int with_checkAlways) {
+
+  /*
+   * The assembler addresses arguments positionally; nsf parameter
+   * definitions (non-positional parameters, value checkers, defaults)
+   * are not supported.
+   */
+  ParamDefsRefCountDecr(parsedParamPtr->paramDefs);
+  return NsfPrintError(interp, "asm proc %s: parameter definitions are not supported: use plain arguments",
+                       ObjStr(nameObj));
 }
 
 static int
@@ -425,6 +916,7 @@ NsfAsmProcAddArgs(Tcl_Interp *interp, Tcl_Obj *argumentsObj,
   cd->paramDefs = NULL;
   cd->with_ad = with_ad;
   cd->with_checkAlways = (with_checkAlways != 0) ? NSF_ARGPARSE_CHECK : 0;
+  cd->refCount = 1;
 
   Tcl_CreateObjCommand(interp, procName, NsfAsmProc,
 		       cd, NsfAsmProcDeleteProc);
@@ -447,12 +939,14 @@ cmd method::asmcreate NsfAsmMethodCreateCmd {
 
 static int
 NsfAsmMethodCreateCmd(Tcl_Interp *interp, NsfObject *defObject,
-		      int withInner_namespace, int withPer_object, NsfObject *regObject,
+		      int with_checkAlways, int withInner_namespace,
+		      int withPer_object, NsfObject *regObject,
 		      Tcl_Obj *nameObj, Tcl_Obj *argumentsObj, Tcl_Obj *bodyObj) {
   int argc, result;
   Tcl_Obj **argv;
   AsmCompiledProc *asmProc;
   AsmProcClientData *cd;
+  NsfParsedParam parsedParam;
   NsfClass *cl =
     (withPer_object || ! NsfObjectIsClass(defObject)) ?
     NULL : (NsfClass *)defObject;
@@ -470,16 +964,40 @@ NsfAsmMethodCreateCmd(Tcl_Interp *interp, NsfObject *defObject,
   if (unlikely(Tcl_ListObjGetElements(interp, argumentsObj, &argc, &argv) != TCL_OK)) {
     return NsfPrintError(interp, "argument list invalid '%s'", ObjStr(argumentsObj));
   }
-  
-  result = AsmAssemble(NULL, interp, nameObj, argc, bodyObj, &asmProc);
+
+  /*
+   * Typed parameters are kept in the parameter definitions, their
+   * values are checked before the code is executed.
+   */
+  result = ParamDefsParse(interp, nameObj, argumentsObj,
+                          NSF_DISALLOWED_ARG_METHOD_PARAMETER, 0,
+                          &parsedParam);
   if (unlikely(result != TCL_OK)) {
     return result;
   }
+  if (parsedParam.paramDefs != NULL) {
+    result = AsmParamDefsCheck(interp, nameObj, parsedParam.paramDefs, NULL);
+    if (likely(result == TCL_OK)) {
+      result = AsmAssemble(NULL, interp, nameObj, argc, bodyObj, &asmProc);
+    }
+    if (unlikely(result != TCL_OK)) {
+      ParamDefsRefCountDecr(parsedParam.paramDefs);
+      return result;
+    }
+  } else {
+    result = AsmAssemble(NULL, interp, nameObj, argc, bodyObj, &asmProc);
+    if (unlikely(result != TCL_OK)) {
+      return result;
+    }
+  }
 
   cd = NEW(AsmProcClientData);
+  cd->object = NULL;
   cd->proc = asmProc;
-  cd->paramDefs = NULL;
+  cd->paramDefs = parsedParam.paramDefs;
   cd->with_ad = 0;
+  cd->with_checkAlways = (with_checkAlways != 0) ? NSF_ARGPARSE_CHECK : 0;
+  cd->refCount = 1;
 
   if (cl == NULL) {
     result = NsfAddObjectMethod(interp, (Nsf_Object *)defObject, ObjStr(nameObj),
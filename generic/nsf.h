@@ -219,10 +219,13 @@
 # define NSF_MEM_COUNT 1
 #endif
 
-#if defined(NSF_PROFILE) || defined(NSF_DTRACE)
+#if defined(NSF_PROFILE)
 # define CscInit(cscPtr, object, cl, cmd, frametype, flags, method) \
   CscInit_((cscPtr), (object), (cl), (cmd), (frametype), (flags)); (cscPtr)->methodName = (method); \
   NsfProfileTraceCall((interp), (object), (cl), (cscPtr)->methodName);
+#elif defined(NSF_DTRACE)
+# define CscInit(cscPtr, object, cl, cmd, frametype, flags, method) \
+  CscInit_((cscPtr), (object), (cl), (cmd), (frametype), (flags)); (cscPtr)->methodName = (method)
 #else
 # define CscInit(cscPtr, object, cl, cmd, frametype, flags, methodName) \
   CscInit_((cscPtr), (object), (cl), (cmd), (frametype), (flags))
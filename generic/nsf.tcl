@@ -97,8 +97,18 @@ namespace eval ::nsf {
   ######################################################################
   # unknown handler for objects and classes
   #
+  # A handler can be registered with a glob pattern for the (fully
+  # qualified) names it handles; the handler is only called for
+  # matching names. The list of all patterns is checked in C before
+  # ::nsf::object::unknown is called, therefore handlers have to be
+  # registered via ::nsf::object::unknown::add.
+  #
   proc ::nsf::object::unknown {name} {
     foreach {key handler} [array get ::nsf::object::unknown] {
+      if {[info exists ::nsf::object::unknown::pattern($key)]
+	  && ![string match $::nsf::object::unknown::pattern($key) $name]} {
+	continue
+      }
       set result [uplevel [list {*}$handler $name]]
       if {$result ne ""} {
 	return $result
@@ -107,10 +117,21 @@ namespace eval ::nsf {
     return ""
   }
   namespace eval ::nsf::object::unknown {
-    proc add {key handler} {set ::nsf::object::unknown($key) $handler}
+    proc add {key handler {pattern *}} {
+      set ::nsf::object::unknown::pattern($key) $pattern
+      set ::nsf::object::unknown($key) $handler
+      update-patterns
+    }
     proc get {key}         {return $::nsf::object::unknown($key)}
-    proc delete {key}      {array unset ::nsf::object::unknown($key)}
+    proc delete {key}      {
+      unset -nocomplain ::nsf::object::unknown::pattern($key) ::nsf::object::unknown($key)
+      update-patterns
+    }
     proc keys {}           {array names ::nsf::object::unknown}
+    proc update-patterns {} {
+      set ::nsf::object::unknown::patterns \
+	  [lsort -unique [dict values [array get ::nsf::object::unknown::pattern]]]
+    }
   }
 
   # Example unknown handler:
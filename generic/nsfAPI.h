@@ -155,6 +155,19 @@ static int ConvertToCurrentoption(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param
   return result;
 }
   
+enum PointersubcmdIdx {PointersubcmdNULL, PointersubcmdAddIdx, PointersubcmdGetIdx, PointersubcmdDeleteIdx};
+
+static int ConvertToPointersubcmd(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
+			    ClientData *clientData, Tcl_Obj **outObjPtr) {
+  int index, result;
+  static const char *opts[] = {"add", "get", "delete", NULL};
+  (void)pPtr;
+  result = Tcl_GetIndexFromObj(interp, objPtr, opts, "pointersubcmd", 0, &index);
+  *clientData = (ClientData) INT2PTR(index + 1);
+  *outObjPtr = objPtr;
+  return result;
+}
+  
 enum FrameIdx {FrameNULL, FrameMethodIdx, FrameObjectIdx, FrameDefaultIdx};
 
 static int ConvertToFrame(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
@@ -207,6 +220,19 @@ static int ConvertToAssertionsubcmd(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Par
   return result;
 }
   
+enum MethodcompileIdx {MethodcompileNULL, MethodcompileAsmIdx, MethodcompileTclIdx};
+
+static int ConvertToMethodcompile(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
+			    ClientData *clientData, Tcl_Obj **outObjPtr) {
+  int index, result;
+  static const char *opts[] = {"asm", "tcl", NULL};
+  (void)pPtr;
+  result = Tcl_GetIndexFromObj(interp, objPtr, opts, "methodcompile", 0, &index);
+  *clientData = (ClientData) INT2PTR(index + 1);
+  *outObjPtr = objPtr;
+  return result;
+}
+  
 enum MethodpropertyIdx {MethodpropertyNULL, MethodpropertyClass_onlyIdx, MethodpropertyCall_privateIdx, MethodpropertyCall_protectedIdx, MethodpropertyRedefine_protectedIdx, MethodpropertyReturnsIdx};
 
 static int ConvertToMethodproperty(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
@@ -246,6 +272,32 @@ static int ConvertToParametersubcmd(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Par
   return result;
 }
   
+enum CallgraphformatIdx {CallgraphformatNULL, CallgraphformatDictIdx, CallgraphformatCallgrindIdx};
+
+static int ConvertToCallgraphformat(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
+			    ClientData *clientData, Tcl_Obj **outObjPtr) {
+  int index, result;
+  static const char *opts[] = {"dict", "callgrind", NULL};
+  (void)pPtr;
+  result = Tcl_GetIndexFromObj(interp, objPtr, opts, "callgraphformat", 0, &index);
+  *clientData = (ClientData) INT2PTR(index + 1);
+  *outObjPtr = objPtr;
+  return result;
+}
+  
+enum ProfilemodeIdx {ProfilemodeNULL, ProfilemodeLabelsIdx, ProfilemodePointersIdx};
+
+static int ConvertToProfilemode(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
+			    ClientData *clientData, Tcl_Obj **outObjPtr) {
+  int index, result;
+  static const char *opts[] = {"labels", "pointers", NULL};
+  (void)pPtr;
+  result = Tcl_GetIndexFromObj(interp, objPtr, opts, "profilemode", 0, &index);
+  *clientData = (ClientData) INT2PTR(index + 1);
+  *outObjPtr = objPtr;
+  return result;
+}
+  
 enum RelationtypeIdx {RelationtypeNULL, RelationtypeObject_mixinIdx, RelationtypeClass_mixinIdx, RelationtypeObject_filterIdx, RelationtypeClass_filterIdx, RelationtypeClassIdx, RelationtypeSuperclassIdx, RelationtypeRootclassIdx};
 
 static int ConvertToRelationtype(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
@@ -259,6 +311,19 @@ static int ConvertToRelationtype(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param
   return result;
 }
   
+enum StatssubcmdIdx {StatssubcmdNULL, StatssubcmdClassesIdx, StatssubcmdSummaryIdx};
+
+static int ConvertToStatssubcmd(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
+			    ClientData *clientData, Tcl_Obj **outObjPtr) {
+  int index, result;
+  static const char *opts[] = {"classes", "summary", NULL};
+  (void)pPtr;
+  result = Tcl_GetIndexFromObj(interp, objPtr, opts, "statssubcmd", 0, &index);
+  *clientData = (ClientData) INT2PTR(index + 1);
+  *outObjPtr = objPtr;
+  return result;
+}
+  
 enum InfoobjectparametersubcmdIdx {InfoobjectparametersubcmdNULL, InfoobjectparametersubcmdDefinitionsIdx, InfoobjectparametersubcmdListIdx, InfoobjectparametersubcmdNamesIdx, InfoobjectparametersubcmdSyntaxIdx};
 
 static int ConvertToInfoobjectparametersubcmd(Tcl_Interp *interp, Tcl_Obj *objPtr, Nsf_Param const *pPtr,
@@ -282,20 +347,25 @@ static int ConvertToInfoobjectparametersubcmd(Tcl_Interp *interp, Tcl_Obj *objPt
   {ConvertToFrame, "method|object|default"},
   {ConvertToCurrentoption, "proc|method|methodpath|object|class|activelevel|args|activemixin|calledproc|calledmethod|calledclass|callingproc|callingmethod|callingclass|callinglevel|callingobject|filterreg|isnextcall|nextmethod"},
   {ConvertToMethodproperty, "class-only|call-private|call-protected|redefine-protected|returns"},
+  {ConvertToCallgraphformat, "dict|callgrind"},
   {ConvertToRelationtype, "object-mixin|class-mixin|object-filter|class-filter|class|superclass|rootclass"},
   {ConvertToSource, "all|application|system"},
+  {ConvertToMethodcompile, "asm|tcl"},
   {ConvertToForwardproperty, "prefix|target|verbose"},
   {ConvertToConfigureoption, "debug|dtrace|filter|profile|trace|softrecreate|objectsystems|keepcmds|checkresults|checkarguments"},
   {ConvertToObjectproperty, "initialized|class|rootmetaclass|rootclass|volatile|slotcontainer|hasperobjectslots|keepcallerself|perobjectdispatch"},
+  {ConvertToStatssubcmd, "classes|summary"},
+  {ConvertToProfilemode, "labels|pointers"},
   {ConvertToAssertionsubcmd, "check|object-invar|class-invar"},
   {ConvertToParametersubcmd, "default|list|name|syntax|type"},
+  {ConvertToPointersubcmd, "add|get|delete"},
   {ConvertToProtection, "call-protected|redefine-protected|none"},
   {NULL, NULL}
 };
     
 
 /* just to define the symbol */
-static Nsf_methodDefinition method_definitions[112];
+static Nsf_methodDefinition method_definitions[124];
   
 static const char *method_command_namespace_names[] = {
   "::nsf::methods::object::info",
@@ -361,14 +431,20 @@ static int NsfCurrentCmdStub(ClientData clientData, Tcl_Interp *interp, int objc
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDebugCompileEpochStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfDebugPointerCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDebugRunAssertionsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDebugShowObjStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfDebugVarCacheStatsStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDirectDispatchCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDispatchCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfDispatchStatsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfFinalizeCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfForwardPropertyCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
@@ -419,10 +495,26 @@ static int NsfParameterSpecsCmdStub(ClientData clientData, Tcl_Interp *interp, i
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfProcCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileAllocStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileCallGraphStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileCheckHistogramStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfProfileClearDataStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileGetAllocStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileGetCallGraphStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfProfileGetDataStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileGetSamplesStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileModeStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
+static int NsfProfileSampleStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfProfileTraceStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfRelationGetCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
@@ -433,6 +525,8 @@ static int NsfSelfCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, T
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfShowStackCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
+static int NsfStatsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
+  NSF_nonnull(2) NSF_nonnull(4);
 static int NsfUnsetUnknownArgsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
   NSF_nonnull(2) NSF_nonnull(4);
 static int NsfVarExistsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv)
@@ -552,7 +646,7 @@ static int NsfClassInfoForwardMethod(Tcl_Interp *interp, NsfClass *cl, int withD
   NSF_nonnull(1) NSF_nonnull(2);
 static int NsfClassInfoHeritageMethod(Tcl_Interp *interp, NsfClass *cl, const char *pattern)
   NSF_nonnull(1) NSF_nonnull(2);
-static int NsfClassInfoInstancesMethod(Tcl_Interp *interp, NsfClass *cl, int withClosure, const char *patternString, NsfObject *patternObject)
+static int NsfClassInfoInstancesMethod(Tcl_Interp *interp, NsfClass *cl, int withClosure, int withCount, const char *patternString, NsfObject *patternObject)
   NSF_nonnull(1) NSF_nonnull(2);
 static int NsfClassInfoMethodMethod(Tcl_Interp *interp, NsfClass *cl, int subcmd, Tcl_Obj *name)
   NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(4);
@@ -584,14 +678,20 @@ static int NsfCurrentCmd(Tcl_Interp *interp, int option)
   NSF_nonnull(1);
 static int NsfDebugCompileEpoch(Tcl_Interp *interp)
   NSF_nonnull(1);
+static int NsfDebugPointerCmd(Tcl_Interp *interp, int subcmd, Tcl_Obj *handle)
+  NSF_nonnull(1);
 static int NsfDebugRunAssertionsCmd(Tcl_Interp *interp)
   NSF_nonnull(1);
 static int NsfDebugShowObj(Tcl_Interp *interp, Tcl_Obj *obj)
   NSF_nonnull(1) NSF_nonnull(2);
+static int NsfDebugVarCacheStats(Tcl_Interp *interp, int withReset)
+  NSF_nonnull(1);
 static int NsfDirectDispatchCmd(Tcl_Interp *interp, NsfObject *object, int withFrame, Tcl_Obj *command, int nobjc, Tcl_Obj *CONST* nobjv)
   NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(4);
 static int NsfDispatchCmd(Tcl_Interp *interp, NsfObject *object, int withIntrinsic, int withSystem, Tcl_Obj *command, int nobjc, Tcl_Obj *CONST* nobjv)
   NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(5);
+static int NsfDispatchStatsCmd(Tcl_Interp *interp, Tcl_Obj *withEnable, int withReset)
+  NSF_nonnull(1);
 static int NsfFinalizeCmd(Tcl_Interp *interp, int withKeepvars)
   NSF_nonnull(1);
 static int NsfForwardPropertyCmd(Tcl_Interp *interp, NsfObject *object, int withPer_object, Tcl_Obj *methodName, int forwardProperty, Tcl_Obj *value)
@@ -604,8 +704,8 @@ static int NsfMethodAliasCmd(Tcl_Interp *interp, NsfObject *object, int withPer_
   NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(4) NSF_nonnull(7);
 static int NsfMethodAssertionCmd(Tcl_Interp *interp, NsfObject *object, int subcmd, Tcl_Obj *arg)
   NSF_nonnull(1) NSF_nonnull(2);
-static int NsfMethodCreateCmd(Tcl_Interp *interp, NsfObject *object, int withCheckalways, int withInner_namespace, int withPer_object, NsfObject *withReg_object, Tcl_Obj *methodName, Tcl_Obj *arguments, Tcl_Obj *body, Tcl_Obj *withPrecondition, Tcl_Obj *withPostcondition)
-  NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(7) NSF_nonnull(8) NSF_nonnull(9);
+static int NsfMethodCreateCmd(Tcl_Interp *interp, NsfObject *object, int withCheckalways, int withInner_namespace, int withPer_object, NsfObject *withReg_object, int withCompile, Tcl_Obj *methodName, Tcl_Obj *arguments, Tcl_Obj *body, Tcl_Obj *withPrecondition, Tcl_Obj *withPostcondition)
+  NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(8) NSF_nonnull(9) NSF_nonnull(10);
 static int NsfMethodDeleteCmd(Tcl_Interp *interp, NsfObject *object, int withPer_object, Tcl_Obj *methodName)
   NSF_nonnull(1) NSF_nonnull(2) NSF_nonnull(4);
 static int NsfMethodForwardCmd(Tcl_Interp *interp, NsfObject *object, int withPer_object, Tcl_Obj *method, Tcl_Obj *withDefault, int withEarlybinding, Tcl_Obj *withOnerror, Tcl_Obj *withPrefix, int withFrame, int withVerbose, Tcl_Obj *target, int nobjc, Tcl_Obj *CONST* nobjv)
@@ -642,9 +742,25 @@ static int NsfParameterSpecsCmd(Tcl_Interp *interp, int withConfigure, int withN
   NSF_nonnull(1) NSF_nonnull(4);
 static int NsfProcCmd(Tcl_Interp *interp, int withAd, int withCheckalways, Tcl_Obj *procName, Tcl_Obj *arguments, Tcl_Obj *body)
   NSF_nonnull(1) NSF_nonnull(4) NSF_nonnull(5) NSF_nonnull(6);
+static int NsfProfileAllocStub(Tcl_Interp *interp, int withEnable)
+  NSF_nonnull(1);
+static int NsfProfileCallGraphStub(Tcl_Interp *interp, int withEnable)
+  NSF_nonnull(1);
+static int NsfProfileCheckHistogramStub(Tcl_Interp *interp)
+  NSF_nonnull(1);
 static int NsfProfileClearDataStub(Tcl_Interp *interp)
   NSF_nonnull(1);
-static int NsfProfileGetDataStub(Tcl_Interp *interp)
+static int NsfProfileGetAllocStub(Tcl_Interp *interp)
+  NSF_nonnull(1);
+static int NsfProfileGetCallGraphStub(Tcl_Interp *interp, int withFormat)
+  NSF_nonnull(1);
+static int NsfProfileGetDataStub(Tcl_Interp *interp, int withReset)
+  NSF_nonnull(1);
+static int NsfProfileGetSamplesStub(Tcl_Interp *interp)
+  NSF_nonnull(1);
+static int NsfProfileModeStub(Tcl_Interp *interp, int mode)
+  NSF_nonnull(1);
+static int NsfProfileSampleStub(Tcl_Interp *interp, int withEnable, int withInterval)
   NSF_nonnull(1);
 static int NsfProfileTraceStub(Tcl_Interp *interp, int withEnable, int withVerbose, int withDontsave, Tcl_Obj *withBuiltins)
   NSF_nonnull(1);
@@ -656,6 +772,8 @@ static int NsfSelfCmd(Tcl_Interp *interp)
   NSF_nonnull(1);
 static int NsfShowStackCmd(Tcl_Interp *interp)
   NSF_nonnull(1);
+static int NsfStatsCmd(Tcl_Interp *interp, int subcmd, const char *pattern)
+  NSF_nonnull(1);
 static int NsfUnsetUnknownArgsCmd(Tcl_Interp *interp)
   NSF_nonnull(1);
 static int NsfVarExistsCmd(Tcl_Interp *interp, int withArray, NsfObject *object, const char *varName)
@@ -779,10 +897,13 @@ enum {
  NsfConfigureCmdIdx,
  NsfCurrentCmdIdx,
  NsfDebugCompileEpochIdx,
+ NsfDebugPointerCmdIdx,
  NsfDebugRunAssertionsCmdIdx,
  NsfDebugShowObjIdx,
+ NsfDebugVarCacheStatsIdx,
  NsfDirectDispatchCmdIdx,
  NsfDispatchCmdIdx,
+ NsfDispatchStatsCmdIdx,
  NsfFinalizeCmdIdx,
  NsfForwardPropertyCmdIdx,
  NsfInterpObjCmdIdx,
@@ -808,13 +929,22 @@ enum {
  NsfParameterInfoCmdIdx,
  NsfParameterSpecsCmdIdx,
  NsfProcCmdIdx,
+ NsfProfileAllocStubIdx,
+ NsfProfileCallGraphStubIdx,
+ NsfProfileCheckHistogramStubIdx,
  NsfProfileClearDataStubIdx,
+ NsfProfileGetAllocStubIdx,
+ NsfProfileGetCallGraphStubIdx,
  NsfProfileGetDataStubIdx,
+ NsfProfileGetSamplesStubIdx,
+ NsfProfileModeStubIdx,
+ NsfProfileSampleStubIdx,
  NsfProfileTraceStubIdx,
  NsfRelationGetCmdIdx,
  NsfRelationSetCmdIdx,
  NsfSelfCmdIdx,
  NsfShowStackCmdIdx,
+ NsfStatsCmdIdx,
  NsfUnsetUnknownArgsCmdIdx,
  NsfVarExistsCmdIdx,
  NsfVarGetCmdIdx,
@@ -1192,12 +1322,13 @@ NsfClassInfoInstancesMethodStub(ClientData clientData, Tcl_Interp *interp, int o
                      method_definitions[NsfClassInfoInstancesMethodIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
                      &pc) == TCL_OK)) {
     int withClosure = (int )PTR2INT(pc.clientData[0]);
+    int withCount = (int )PTR2INT(pc.clientData[1]);
     const char *patternString = NULL;
     NsfObject *patternObject = NULL;
-    Tcl_Obj *pattern = (Tcl_Obj *)pc.clientData[1];
+    Tcl_Obj *pattern = (Tcl_Obj *)pc.clientData[2];
     int returnCode;
 
-    if (GetMatchObject(interp, pattern, objc>1 ? objv[1] : NULL, &patternObject, &patternString) == -1) {
+    if (GetMatchObject(interp, pattern, objc>2 ? objv[2] : NULL, &patternObject, &patternString) == -1) {
       if (pattern) {
         DECR_REF_COUNT2("patternObj", pattern);
       }
@@ -1205,14 +1336,14 @@ NsfClassInfoInstancesMethodStub(ClientData clientData, Tcl_Interp *interp, int o
     }
           
     assert(pc.status == 0);
-    returnCode = NsfClassInfoInstancesMethod(interp, cl, withClosure, patternString, patternObject);
+    returnCode = NsfClassInfoInstancesMethod(interp, cl, withClosure, withCount, patternString, patternObject);
 
     if (pattern) {
       DECR_REF_COUNT2("patternObj", pattern);
     }
     return returnCode;
   } else {
-    Tcl_Obj *pattern = (Tcl_Obj *)pc.clientData[1];
+    Tcl_Obj *pattern = (Tcl_Obj *)pc.clientData[2];
 
     if (pattern) {
       DECR_REF_COUNT2("patternObj", pattern);
@@ -1637,6 +1768,27 @@ NsfDebugCompileEpochStub(ClientData clientData, Tcl_Interp *interp, int objc, Tc
 
 }
 
+static int
+NsfDebugPointerCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfDebugPointerCmdIdx].paramDefs,
+                     method_definitions[NsfDebugPointerCmdIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int subcmd = (int )PTR2INT(pc.clientData[0]);
+    Tcl_Obj *handle = (Tcl_Obj *)pc.clientData[1];
+
+    assert(pc.status == 0);
+    return NsfDebugPointerCmd(interp, subcmd, handle);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfDebugRunAssertionsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   (void)clientData;
@@ -1669,6 +1821,26 @@ NsfDebugShowObjStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
 
 }
 
+static int
+NsfDebugVarCacheStatsStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfDebugVarCacheStatsIdx].paramDefs,
+                     method_definitions[NsfDebugVarCacheStatsIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withReset = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfDebugVarCacheStats(interp, withReset);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfDirectDispatchCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   ParseContext pc;
@@ -1714,6 +1886,27 @@ NsfDispatchCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
   }
 }
 
+static int
+NsfDispatchStatsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfDispatchStatsCmdIdx].paramDefs,
+                     method_definitions[NsfDispatchStatsCmdIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    Tcl_Obj *withEnable = (Tcl_Obj *)pc.clientData[0];
+    int withReset = (int )PTR2INT(pc.clientData[1]);
+
+    assert(pc.status == 0);
+    return NsfDispatchStatsCmd(interp, withEnable, withReset);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfFinalizeCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   ParseContext pc;
@@ -1863,14 +2056,15 @@ NsfMethodCreateCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_
     int withInner_namespace = (int )PTR2INT(pc.clientData[2]);
     int withPer_object = (int )PTR2INT(pc.clientData[3]);
     NsfObject *withReg_object = (NsfObject *)pc.clientData[4];
-    Tcl_Obj *methodName = (Tcl_Obj *)pc.clientData[5];
-    Tcl_Obj *arguments = (Tcl_Obj *)pc.clientData[6];
-    Tcl_Obj *body = (Tcl_Obj *)pc.clientData[7];
-    Tcl_Obj *withPrecondition = (Tcl_Obj *)pc.clientData[8];
-    Tcl_Obj *withPostcondition = (Tcl_Obj *)pc.clientData[9];
+    int withCompile = (int )PTR2INT(pc.clientData[5]);
+    Tcl_Obj *methodName = (Tcl_Obj *)pc.clientData[6];
+    Tcl_Obj *arguments = (Tcl_Obj *)pc.clientData[7];
+    Tcl_Obj *body = (Tcl_Obj *)pc.clientData[8];
+    Tcl_Obj *withPrecondition = (Tcl_Obj *)pc.clientData[9];
+    Tcl_Obj *withPostcondition = (Tcl_Obj *)pc.clientData[10];
 
     assert(pc.status == 0);
-    return NsfMethodCreateCmd(interp, object, withCheckalways, withInner_namespace, withPer_object, withReg_object, methodName, arguments, body, withPrecondition, withPostcondition);
+    return NsfMethodCreateCmd(interp, object, withCheckalways, withInner_namespace, withPer_object, withReg_object, withCompile, methodName, arguments, body, withPrecondition, withPostcondition);
 
   } else {
     
@@ -2257,6 +2451,62 @@ NsfProcCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CON
   }
 }
 
+static int
+NsfProfileAllocStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileAllocStubIdx].paramDefs,
+                     method_definitions[NsfProfileAllocStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withEnable = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfProfileAllocStub(interp, withEnable);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
+static int
+NsfProfileCallGraphStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileCallGraphStubIdx].paramDefs,
+                     method_definitions[NsfProfileCallGraphStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withEnable = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfProfileCallGraphStub(interp, withEnable);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
+static int
+NsfProfileCheckHistogramStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  (void)clientData;
+
+    
+
+      if (unlikely(objc != 1)) {
+	return NsfArgumentError(interp, "too many arguments:",
+			     method_definitions[NsfProfileCheckHistogramStubIdx].paramDefs,
+			     NULL, objv[0]);
+      }
+    
+    return NsfProfileCheckHistogramStub(interp);
+
+}
+
 static int
 NsfProfileClearDataStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   (void)clientData;
@@ -2273,22 +2523,119 @@ NsfProfileClearDataStubStub(ClientData clientData, Tcl_Interp *interp, int objc,
 
 }
 
+static int
+NsfProfileGetAllocStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  (void)clientData;
+
+    
+
+      if (unlikely(objc != 1)) {
+	return NsfArgumentError(interp, "too many arguments:",
+			     method_definitions[NsfProfileGetAllocStubIdx].paramDefs,
+			     NULL, objv[0]);
+      }
+    
+    return NsfProfileGetAllocStub(interp);
+
+}
+
+static int
+NsfProfileGetCallGraphStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileGetCallGraphStubIdx].paramDefs,
+                     method_definitions[NsfProfileGetCallGraphStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withFormat = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfProfileGetCallGraphStub(interp, withFormat);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfProfileGetDataStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileGetDataStubIdx].paramDefs,
+                     method_definitions[NsfProfileGetDataStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withReset = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfProfileGetDataStub(interp, withReset);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
+static int
+NsfProfileGetSamplesStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   (void)clientData;
 
     
 
       if (unlikely(objc != 1)) {
 	return NsfArgumentError(interp, "too many arguments:",
-			     method_definitions[NsfProfileGetDataStubIdx].paramDefs,
+			     method_definitions[NsfProfileGetSamplesStubIdx].paramDefs,
 			     NULL, objv[0]);
       }
     
-    return NsfProfileGetDataStub(interp);
+    return NsfProfileGetSamplesStub(interp);
 
 }
 
+static int
+NsfProfileModeStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileModeStubIdx].paramDefs,
+                     method_definitions[NsfProfileModeStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int mode = (int )PTR2INT(pc.clientData[0]);
+
+    assert(pc.status == 0);
+    return NsfProfileModeStub(interp, mode);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
+static int
+NsfProfileSampleStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfProfileSampleStubIdx].paramDefs,
+                     method_definitions[NsfProfileSampleStubIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int withEnable = (int )PTR2INT(pc.clientData[0]);
+    int withInterval = (int )PTR2INT(pc.clientData[1]);
+
+    assert(pc.status == 0);
+    return NsfProfileSampleStub(interp, withEnable, withInterval);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfProfileTraceStubStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   ParseContext pc;
@@ -2387,6 +2734,27 @@ NsfShowStackCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj
 
 }
 
+static int
+NsfStatsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
+  ParseContext pc;
+  (void)clientData;
+
+  if (likely(ArgumentParse(interp, objc, objv, NULL, objv[0],
+                     method_definitions[NsfStatsCmdIdx].paramDefs,
+                     method_definitions[NsfStatsCmdIdx].nrParameters, 0, NSF_ARGPARSE_BUILTIN,
+                     &pc) == TCL_OK)) {
+    int subcmd = (int )PTR2INT(pc.clientData[0]);
+    const char *pattern = (const char *)pc.clientData[1];
+
+    assert(pc.status == 0);
+    return NsfStatsCmd(interp, subcmd, pattern);
+
+  } else {
+    
+    return TCL_ERROR;
+  }
+}
+
 static int
 NsfUnsetUnknownArgsCmdStub(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *CONST* objv) {
   (void)clientData;
@@ -3447,7 +3815,7 @@ NsfObjInfoVarsMethodStub(ClientData clientData, Tcl_Interp *interp, int objc, Tc
   }
 }
 
-static Nsf_methodDefinition method_definitions[112] = {
+static Nsf_methodDefinition method_definitions[124] = {
 {"::nsf::methods::class::alloc", NsfCAllocMethodStub, 1, {
   {"objectName", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
@@ -3494,8 +3862,9 @@ static Nsf_methodDefinition method_definitions[112] = {
 {"::nsf::methods::class::info::heritage", NsfClassInfoHeritageMethodStub, 1, {
   {"pattern", 0, 1, Nsf_ConvertTo_String, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
-{"::nsf::methods::class::info::instances", NsfClassInfoInstancesMethodStub, 2, {
+{"::nsf::methods::class::info::instances", NsfClassInfoInstancesMethodStub, 3, {
   {"-closure", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL},
+  {"-count", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL},
   {"pattern", 0, 1, ConvertToObjpattern, NULL,NULL,"objpattern",NULL,NULL,NULL,NULL,NULL}}
 },
 {"::nsf::methods::class::info::method", NsfClassInfoMethodMethodStub, 2, {
@@ -3575,12 +3944,19 @@ static Nsf_methodDefinition method_definitions[112] = {
 {"::nsf::__db_compile_epoch", NsfDebugCompileEpochStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::__db_pointer", NsfDebugPointerCmdStub, 2, {
+  {"subcmd", NSF_ARG_REQUIRED|NSF_ARG_IS_ENUMERATION, 1, ConvertToPointersubcmd, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
+  {"handle", 0, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::__db_run_assertions", NsfDebugRunAssertionsCmdStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
 {"::nsf::__db_show_obj", NsfDebugShowObjStub, 1, {
   {"obj", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::__db_varcache_stats", NsfDebugVarCacheStatsStub, 1, {
+  {"-reset", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::directdispatch", NsfDirectDispatchCmdStub, 4, {
   {"object", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Object, NULL,NULL,"object",NULL,NULL,NULL,NULL,NULL},
   {"-frame", NSF_ARG_IS_ENUMERATION, 1, ConvertToFrame, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
@@ -3594,6 +3970,10 @@ static Nsf_methodDefinition method_definitions[112] = {
   {"command", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"args", 0, 1, ConvertToNothing, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::__dispatchstats", NsfDispatchStatsCmdStub, 2, {
+  {"-enable", 0, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
+  {"-reset", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::finalize", NsfFinalizeCmdStub, 1, {
   {"-keepvars", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL}}
 },
@@ -3628,12 +4008,13 @@ static Nsf_methodDefinition method_definitions[112] = {
   {"subcmd", NSF_ARG_REQUIRED|NSF_ARG_IS_ENUMERATION, 1, ConvertToAssertionsubcmd, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"arg", 0, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
-{"::nsf::method::create", NsfMethodCreateCmdStub, 10, {
+{"::nsf::method::create", NsfMethodCreateCmdStub, 11, {
   {"object", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Object, NULL,NULL,"object",NULL,NULL,NULL,NULL,NULL},
   {"-checkalways", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL},
   {"-inner-namespace", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL},
   {"-per-object", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL},
   {"-reg-object", 0, 1, Nsf_ConvertTo_Object, NULL,NULL,"object",NULL,NULL,NULL,NULL,NULL},
+  {"-compile", NSF_ARG_IS_ENUMERATION, 1, ConvertToMethodcompile, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"methodName", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"arguments", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"body", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
@@ -3731,12 +4112,37 @@ static Nsf_methodDefinition method_definitions[112] = {
   {"arguments", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
   {"body", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Tclobj, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::__profile_alloc", NsfProfileAllocStubStub, 1, {
+  {"-enable", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Boolean, NULL,NULL,"boolean",NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_callgraph", NsfProfileCallGraphStubStub, 1, {
+  {"-enable", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Boolean, NULL,NULL,"boolean",NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_check_histogram", NsfProfileCheckHistogramStubStub, 0, {
+  {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::__profile_clear", NsfProfileClearDataStubStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
-{"::nsf::__profile_get", NsfProfileGetDataStubStub, 0, {
+{"::nsf::__profile_get_alloc", NsfProfileGetAllocStubStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::__profile_get_callgraph", NsfProfileGetCallGraphStubStub, 1, {
+  {"-format", NSF_ARG_IS_ENUMERATION, 1, ConvertToCallgraphformat, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_get", NsfProfileGetDataStubStub, 1, {
+  {"-reset", 0, 0, Nsf_ConvertTo_Boolean, NULL,NULL,"switch",NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_samples", NsfProfileGetSamplesStubStub, 0, {
+  {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_mode", NsfProfileModeStubStub, 1, {
+  {"mode", NSF_ARG_IS_ENUMERATION, 1, ConvertToProfilemode, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
+{"::nsf::__profile_sample", NsfProfileSampleStubStub, 2, {
+  {"-enable", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Boolean, NULL,NULL,"boolean",NULL,NULL,NULL,NULL,NULL},
+  {"-interval", 0, 1, Nsf_ConvertTo_Int32, NULL,NULL,"int32",NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::__profile_trace", NsfProfileTraceStubStub, 4, {
   {"-enable", NSF_ARG_REQUIRED, 1, Nsf_ConvertTo_Boolean, NULL,NULL,"boolean",NULL,NULL,NULL,NULL,NULL},
   {"-verbose", 0, 1, Nsf_ConvertTo_Boolean, NULL,NULL,"boolean",NULL,NULL,NULL,NULL,NULL},
@@ -3758,6 +4164,10 @@ static Nsf_methodDefinition method_definitions[112] = {
 {"::nsf::__db_show_stack", NsfShowStackCmdStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
+{"::nsf::stats", NsfStatsCmdStub, 2, {
+  {"subcmd", NSF_ARG_REQUIRED|NSF_ARG_IS_ENUMERATION, 1, ConvertToStatssubcmd, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL},
+  {"pattern", 0, 1, Nsf_ConvertTo_String, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
+},
 {"::nsf::__unset_unknown_args", NsfUnsetUnknownArgsCmdStub, 0, {
   {NULL, 0, 0, NULL, NULL,NULL,NULL,NULL,NULL,NULL,NULL,NULL}}
 },
@@ -92,6 +92,10 @@ NsfReportVars(Tcl_Interp *interp) {
   Tcl_SetVar(interp, "::nsf::config(assertions)",
              NsfConfigStr(WITH_ASSERTIONS),
              TCL_GLOBAL_ONLY);
+
+  Tcl_SetVar(interp, "::nsf::config(assemble)",
+             NsfConfigStr(ASSEMBLE),
+             TCL_GLOBAL_ONLY);
 }
 
 /*
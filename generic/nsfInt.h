@@ -79,6 +79,7 @@
 
 #if defined(NSF_PROFILE)
 # include <sys/time.h>
+# include <time.h>
 #endif
 
 #if __GNUC_PREREQ(2, 95)
@@ -98,6 +99,20 @@
 # define pure
 #endif
 
+/*
+ * Lock-free increment of an int counter shared between threads,
+ * returning the value before the increment. When no atomic primitive
+ * is known, NSF_ATOMIC_FETCH_INCR is not defined and the counter has
+ * to be protected by a mutex.
+ */
+#if !defined(TCL_THREADS)
+# define NSF_ATOMIC_FETCH_INCR(intPtr) ((*(intPtr))++)
+#elif __GNUC_PREREQ(4, 1)
+# define NSF_ATOMIC_FETCH_INCR(intPtr) __sync_fetch_and_add((intPtr), 1)
+#elif defined(_MSC_VER)
+# define NSF_ATOMIC_FETCH_INCR(intPtr) (InterlockedIncrement((LONG volatile *)(intPtr)) - 1)
+#endif
+
 #if __GNUC_PREREQ(3, 3)
 # define nonnull(ARGS) __attribute__((__nonnull__(ARGS)))
 #else
@@ -131,7 +146,31 @@
 # define UNUSED(x) (x)
 #endif
 
-#if defined(NSF_DTRACE)
+#if defined(NSF_DTRACE) && defined(NSF_USDT)
+/*
+ * Linux USDT probes (SystemTap sys/sdt.h) with the probe set of
+ * nsfDTrace.d, usable e.g. from bpftrace, perf or stap. The probes are
+ * guarded by semaphores, which are incremented by the tracer when a
+ * probe is attached; the semaphores are defined in nsf.c.
+ */
+# define _SDT_HAS_SEMAPHORES 1
+# include <sys/sdt.h>
+EXTERN unsigned short nsf_method__entry_semaphore;
+EXTERN unsigned short nsf_method__return_semaphore;
+EXTERN unsigned short nsf_object__alloc_semaphore;
+EXTERN unsigned short nsf_object__free_semaphore;
+EXTERN unsigned short nsf_configure__probe_semaphore;
+# define NSF_DTRACE_METHOD_ENTRY_ENABLED()     		unlikely(nsf_method__entry_semaphore != 0)
+# define NSF_DTRACE_METHOD_RETURN_ENABLED()    		unlikely(nsf_method__return_semaphore != 0)
+# define NSF_DTRACE_OBJECT_ALLOC_ENABLED()		unlikely(nsf_object__alloc_semaphore != 0)
+# define NSF_DTRACE_OBJECT_FREE_ENABLED()  		unlikely(nsf_object__free_semaphore != 0)
+# define NSF_DTRACE_CONFIGURE_PROBE_ENABLED()  		unlikely(nsf_configure__probe_semaphore != 0)
+# define NSF_DTRACE_METHOD_ENTRY(a0, a1, a2, a3, a4)	DTRACE_PROBE5(nsf, method__entry, (a0), (a1), (a2), (a3), (a4))
+# define NSF_DTRACE_METHOD_RETURN(a0, a1, a2, a3)      	DTRACE_PROBE4(nsf, method__return, (a0), (a1), (a2), (a3))
+# define NSF_DTRACE_OBJECT_ALLOC(a0, a1)		DTRACE_PROBE2(nsf, object__alloc, (a0), (a1))
+# define NSF_DTRACE_OBJECT_FREE(a0, a1)			DTRACE_PROBE2(nsf, object__free, (a0), (a1))
+# define NSF_DTRACE_CONFIGURE_PROBE(a0, a1)      	DTRACE_PROBE2(nsf, configure__probe, (a0), (a1))
+#elif defined(NSF_DTRACE)
 # include "nsfDTrace.h"
 # define NSF_DTRACE_METHOD_ENTRY_ENABLED()     		unlikely(NSF_METHOD_ENTRY_ENABLED())
 # define NSF_DTRACE_METHOD_RETURN_ENABLED()    		unlikely(NSF_METHOD_RETURN_ENABLED())
@@ -566,10 +605,34 @@ typedef struct NsfObject {
   NsfFilterStack *filterStack;
   NsfMixinStack *mixinStack;
   int refCount;
+  int nrChildren;
   unsigned int flags;
   short activationCount;
 } NsfObject;
 
+/*
+ * Sorted index of the method names defined in a class, used for
+ * restricting method listings to a name prefix. Every entry keeps
+ * its position in the cmd table, such that the results can be
+ * returned in table order. The index is rebuilt lazily when the
+ * methodEpoch of the class or the number of methods has changed.
+ * The names of the unpatterned listings with call protection "all"
+ * and "public" are cached per index, separately for classes and
+ * objects (see MethodIndexNames()).
+ */
+typedef struct NsfMethodIndexEntry {
+  const char *name;
+  int position;
+  Tcl_Command cmd;
+} NsfMethodIndexEntry;
+
+typedef struct NsfMethodIndex {
+  int numEntries;
+  unsigned int methodEpoch;
+  NsfMethodIndexEntry *entries;
+  Tcl_Obj *namesObjs[4];
+} NsfMethodIndex;
+
 typedef struct NsfClassOpt {
   NsfCmdList *classFilters;
   NsfCmdList *classMixins;
@@ -582,6 +645,8 @@ typedef struct NsfClassOpt {
 #endif
   Tcl_Command id;
   ClientData clientData;
+  NsfMethodIndex *methodIndex;
+  unsigned int methodEpoch;
 } NsfClassOpt;
 
 typedef struct NsfClass {
@@ -692,6 +757,7 @@ typedef enum {
   NSF_METHOD,  NSF_OBJECT, NSF_SETTER, NSF_SETTERNAME, NSF_VALUECHECK,
   NSF_GUARD_OPTION, NSF___UNKNOWN__, NSF_ARRAY, NSF_GET, NSF_SET, NSF_OPTION_STRICT,
   NSF_OBJECT_UNKNOWN_HANDLER, NSF_ARGUMENT_UNKNOWN_HANDLER,
+  NSF_OBJECT_UNKNOWN_PATTERNS,
   /* Partly redefined Tcl commands; leave them together at the end */
   NSF_EXPR, NSF_FORMAT, NSF_INFO_BODY, NSF_INFO_FRAME, NSF_INTERP, 
   NSF_STRING_IS, NSF_EVAL,
@@ -718,6 +784,7 @@ char *NsfGlobalStrings[] = {
   /* nsf tcl commands */
   "::nsf::object::unknown",
   "::nsf::argument::unknown",
+  "::nsf::object::unknown::patterns",
   /* tcl commands */
   "expr", "format", "::tcl::info::body", "::tcl::info::frame", "interp", 
   "::tcl::string::is", "::eval",
@@ -790,6 +857,10 @@ typedef struct NsfCallStackContent {
   long int startSec;
   CONST char *methodName;
 #endif
+#if defined(NSF_PROFILE)
+  long int childMicroSec;
+  struct NsfProfileNode *profileNode;
+#endif
 } NsfCallStackContent;
 
 #define NSF_CSC_TYPE_PLAIN                    0U
@@ -858,6 +929,15 @@ typedef struct NsfCallStackContent {
 #endif
 
 #if defined(NSF_PROFILE)
+/*
+ * Profile modes: in the "labels" mode, string labels of objects and
+ * methods are built for every call, in the "pointers" mode, the data
+ * is keyed by the cmd and class pointers and the labels are built
+ * only when the data is requested.
+ */
+# define NSF_PROFILE_MODE_LABELS   0
+# define NSF_PROFILE_MODE_POINTERS 1
+
 typedef struct NsfProfile {
   long int overallTime;
   long int startSec;
@@ -865,17 +945,40 @@ typedef struct NsfProfile {
   Tcl_HashTable objectData;
   Tcl_HashTable methodData;
   Tcl_HashTable procData;
+  Tcl_HashTable callData;
+  Tcl_HashTable objectCallData;
+  struct NsfProfileCallCacheEntry *callCache;
+  Tcl_HashTable sampleData;
+  struct NsfProfileSampler *sampler;
+  struct NsfProfileNode *callGraph;
+  int doCallGraph;
   Tcl_DString traceDs;
   int depth;
   int verbose;
   int inmemory;
+  int mode;
   Tcl_Obj *shadowedObjs;
   NsfShadowTclCommandInfo *shadowedTi;
 } NsfProfile;
 
+/*
+ * Use a monotonic clock for profiling where available, since it is
+ * cheaper on most platforms and not affected by clock adjustments.
+ */
+# if defined(CLOCK_MONOTONIC)
+#  define NSF_PROFILE_GETTIME(tvPtr) do {                        \
+    struct timespec profile_ts;                                  \
+    clock_gettime(CLOCK_MONOTONIC, &profile_ts);                 \
+    (tvPtr)->tv_sec = profile_ts.tv_sec;                         \
+    (tvPtr)->tv_usec = profile_ts.tv_nsec / 1000;                \
+  } while (0)
+# else
+#  define NSF_PROFILE_GETTIME(tvPtr) gettimeofday((tvPtr), NULL)
+# endif
+
 # define NSF_PROFILE_TIME_DATA struct timeval profile_trt
 # define NSF_PROFILE_CALL(interp, object, methodName) \
-  gettimeofday(&profile_trt, NULL); \
+  NSF_PROFILE_GETTIME(&profile_trt); \
   NsfProfileTraceCall(interp, object, NULL, methodName)
 # define NSF_PROFILE_EXIT(interp, object, methodName) \
   NsfProfileTraceExit(interp, object, NULL, methodName, &profile_trt)
@@ -885,6 +988,36 @@ typedef struct NsfProfile {
 # define NSF_PROFILE_EXIT(interp, object, methodName) 
 #endif
 
+/*
+ * Branch counters of the method dispatch (see ObjectDispatch() and the
+ * inline caches of the asm dispatch instructions). The counters are
+ * only incremented when doDispatchStats is set in the runtime state
+ * and are reported by nsf::__dispatchstats.
+ */
+typedef enum {
+  NSF_DISPATCH_OBJECT_CACHE_HIT,
+  NSF_DISPATCH_OBJECT_CACHE_MISS,
+  NSF_DISPATCH_INSTANCE_CACHE_HIT,
+  NSF_DISPATCH_INSTANCE_CACHE_MISS,
+  NSF_DISPATCH_FILTER_PUSH,
+  NSF_DISPATCH_MIXIN_PUSH,
+  NSF_DISPATCH_LOCAL,
+  NSF_DISPATCH_QUALIFIED,
+  NSF_DISPATCH_ENSEMBLE,
+  NSF_DISPATCH_UNKNOWN,
+  NSF_DISPATCH_NRE,
+  NSF_DISPATCH_IMMEDIATE,
+  NSF_DISPATCH_ASM_CACHE_HIT,
+  NSF_DISPATCH_ASM_CACHE_MISS,
+  NSF_DISPATCH_STATS_MAX
+} NsfDispatchStat;
+
+#define NSF_DISPATCH_STAT(rst, stat) do {                               \
+    if (unlikely((rst)->doDispatchStats != 0)) {                        \
+      (rst)->dispatchStats[(stat)]++;                                   \
+    }                                                                   \
+  } while (0)
+
 typedef struct NsfRuntimeState {
   /*
    * The defined object systems
@@ -913,6 +1046,17 @@ typedef struct NsfRuntimeState {
   int errorCount;        /* keep track of number of errors to avoid potential error loops */
   int unknown;           /* keep track whether an unknown method is currently called */
   unsigned int overloadedMethods; /* bitarray for tracking overloaded methods */
+  /*
+   * Hit and miss counts of the compiled colon var cache
+   * (see CompiledColonVarFetch())
+   */
+  unsigned long varCacheHits;
+  unsigned long varCacheMisses;
+  /*
+   * Dispatch branch counters (see NSF_DISPATCH_STAT())
+   */
+  int doDispatchStats;
+  unsigned long dispatchStats[NSF_DISPATCH_STATS_MAX];
   /* 
    * Configure options. The following do*-flags could be moved into a
    * bitarray, but we have only one state per interp, so the win on
@@ -1005,6 +1149,31 @@ EXTERN void NsfCleanupObject_(NsfObject *object) nonnull(1);
  * Profiling functions
  */
 
+/*
+ * Allocation tracking, switchable at runtime (also without
+ * NSF_PROFILE). Allocations are only looked at while tracking is
+ * enabled, frees only while tracked allocations are alive.
+ */
+#define NSF_PROFILE_ALLOC(kind, p, size) do {                           \
+    if (unlikely(NsfProfileAllocTracking != 0)) {                       \
+      NsfProfileAllocTrack((kind), (p), (size));                        \
+    }                                                                   \
+  } while (0)
+#define NSF_PROFILE_FREE(p) do {                                        \
+    if (unlikely(NsfProfileAllocLive != 0)) {                           \
+      NsfProfileAllocUntrack(p);                                        \
+    }                                                                   \
+  } while (0)
+
+EXTERN int NsfProfileAlloc(Tcl_Interp *interp, int withEnable) nonnull(1);
+EXTERN void NsfProfileGetAlloc(Tcl_Interp *interp) nonnull(1);
+EXTERN void NsfProfileAllocTrack(const char *kind, void *p, size_t size) nonnull(1) nonnull(2);
+EXTERN void NsfProfileAllocUntrack(void *p) nonnull(1);
+EXTERN int NsfProfileAllocTracking;
+EXTERN int NsfProfileAllocLive;
+EXTERN NsfCallStackContent *NsfCallStackGetTopFrame(Tcl_Interp *interp, Tcl_CallFrame **framePtrPtr)
+  nonnull(1);
+
 #if defined(NSF_PROFILE)
 EXTERN void NsfProfileRecordMethodData(Tcl_Interp* interp, NsfCallStackContent *cscPtr)
   nonnull(1) nonnull(2);
@@ -1013,7 +1182,9 @@ EXTERN void NsfProfileRecordProcData(Tcl_Interp *interp, const char *methodName,
 EXTERN void NsfProfileInit(Tcl_Interp *interp) nonnull(1);
 EXTERN void NsfProfileFree(Tcl_Interp *interp) nonnull(1);
 EXTERN void NsfProfileClearData(Tcl_Interp *interp) nonnull(1);
-EXTERN void NsfProfileGetData(Tcl_Interp *interp) nonnull(1);
+EXTERN void NsfProfileGetData(Tcl_Interp *interp, int withReset) nonnull(1);
+EXTERN int NsfProfileSetMode(Tcl_Interp *interp, int mode) nonnull(1);
+EXTERN void NsfProfileObjectDelete(Tcl_Interp *interp, NsfObject *object) nonnull(1) nonnull(2);
 EXTERN int NsfProfileTrace(Tcl_Interp *interp, int withEnable, int withVerbose, int withInmemory, Tcl_Obj *builtins);
 
 EXTERN void NsfProfileObjectLabel(Tcl_DString *dsPtr, NsfObject *obj, NsfClass *cl, const char *methodName)
@@ -1027,8 +1198,14 @@ EXTERN void NsfProfileTraceCallAppend(Tcl_Interp *interp, const char *label)
 EXTERN void NsfProfileTraceExitAppend(Tcl_Interp *interp, const char *label, double duration)
   nonnull(1) nonnull(2);
 
-EXTERN NsfCallStackContent *NsfCallStackGetTopFrame(Tcl_Interp *interp, Tcl_CallFrame **framePtrPtr)
-  nonnull(1);
+EXTERN int NsfCallStackFolded(Tcl_Interp *interp, Tcl_DString *dsPtr)
+  nonnull(1) nonnull(2);
+EXTERN Tcl_CallFrame *NsfCallStackNextMethodFrame(Tcl_CallFrame *framePtr);
+EXTERN int NsfProfileSample(Tcl_Interp *interp, int withEnable, int interval) nonnull(1);
+EXTERN int NsfProfileCallGraph(Tcl_Interp *interp, int withEnable) nonnull(1);
+EXTERN int NsfProfileBucketCheck(Tcl_Interp *interp) nonnull(1);
+EXTERN void NsfProfileGetCallGraph(Tcl_Interp *interp, int withCallgrind) nonnull(1);
+EXTERN void NsfProfileGetSamples(Tcl_Interp *interp) nonnull(1);
 #endif
 
 /*
@@ -1090,6 +1267,15 @@ EXTERN int NsfObjDispatch(ClientData cd, Tcl_Interp *interp,
 			  int objc, Tcl_Obj *CONST objv[])
   nonnull(1) nonnull(2) nonnull(4);
 
+EXTERN void NsfObjectChildCountUpdate(Tcl_Command cmd, int delta)
+  nonnull(1);
+EXTERN void NsfClassMethodEpochIncrCmd(Tcl_Interp *interp, Tcl_Command cmd)
+  nonnull(1) nonnull(2);
+EXTERN void NsfCommandPreserve(Tcl_Command cmd)
+  nonnull(1);
+EXTERN void NsfCommandRelease(Tcl_Command cmd)
+  nonnull(1);
+
 EXTERN int NsfObjWrongArgs(Tcl_Interp *interp, CONST char *msg, 
 			   Tcl_Obj *cmdName, Tcl_Obj *methodName, 
 			   char *arglist)
@@ -1124,6 +1310,14 @@ EXTERN Tcl_Obj *NsfMethodNamePath(Tcl_Interp *interp,
 # define NsfObjectMethodEpochIncr(msg)   RUNTIME_STATE(interp)->objectMethodEpoch++
 #endif
 
+/*
+ * The method epoch of a class is incremented whenever a method of
+ * the class is defined, deleted, renamed or changes its call
+ * protection. It invalidates the method index of the class.
+ */
+#define NsfClassMethodEpochIncr(cl) \
+  if ((cl)->opt != NULL) {(cl)->opt->methodEpoch++;}
+
 #if defined(PER_OBJECT_PARAMETER_CACHING)
 # define NsfClassParamPtrEpochIncr(msg)   RUNTIME_STATE(interp)->classParamPtrEpoch++
 #else
@@ -36,10 +36,168 @@
 
 #include "nsfInt.h"
 
+/*
+ * The entries of the pointer table. The generation of an entry is
+ * incremented whenever its pointer is deleted; deleted entries are
+ * kept in a free list and reused by Nsf_PointerAdd(). Therefore, an
+ * entry referenced from the internal representation of a Tcl_Obj
+ * stays valid memory, and the cached generation tells whether the
+ * pointer is still the same. Since such Tcl_Objs might outlive the
+ * last interpreter, the entries are not freed in Nsf_PointerExit(),
+ * but only by the process exit handler PointerFreeEntries().
+ */
+typedef struct NsfPointerEntry {
+  void *valuePtr;
+  int generation;
+  struct NsfPointerEntry *nextPtr;  /* next entry in the free list */
+} NsfPointerEntry;
+
 static Tcl_HashTable pointerHashTable, *pointerHashTablePtr = &pointerHashTable;
+static Tcl_HashTable typeHashTable, *typeHashTablePtr = &typeHashTable;
+static NsfPointerEntry *pointerFreeList = NULL;
 static int pointerTableRefCount = 0;
+static int pointerExitHandlerRegistered = 0;
 static NsfMutex pointerMutex = 0;
 
+/*
+ * The generation and the valuePtr are changed under the pointerMutex,
+ * but read without it in Nsf_ConvertToPointer(). Without atomic
+ * builtins, the reader takes the mutex.
+ */
+#if defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+# define NSF_POINTER_ATOMIC 1
+#endif
+
+/*
+ * The pointer obj type caches the result of a successful lookup of a
+ * pointer key: ptr1 is the NsfPointerEntry, ptr2 its generation at
+ * the time of the lookup. The string representation is always kept.
+ */
+static Tcl_ObjType pointerObjType = {
+  "nsfPointer",			/* name */
+  NULL,				/* freeIntRepProc */
+  NULL,				/* dupIntRepProc */
+  NULL,				/* updateStringProc */
+  NULL				/* setFromAnyProc */
+};
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PointerEntryValue --
+ *
+ *      Read the valuePtr of a pointer entry, provided that the entry
+ *      has still the given generation. The entry might be changed
+ *      concurrently by Nsf_PointerDelete() and Nsf_PointerAdd().
+ *      Since Nsf_PointerDelete() increments the generation before
+ *      the valuePtr is changed, the generation is checked again after
+ *      loading the valuePtr (like a reader of a seqlock).
+ *
+ * Results:
+ *      1 if the entry has the given generation, 0 otherwise.
+ *
+ * Side effects:
+ *      Sets *valuePtrPtr.
+ *
+ *----------------------------------------------------------------------
+ */
+static NSF_INLINE int PointerEntryValue(NsfPointerEntry *entryPtr, int generation, void **valuePtrPtr)
+  nonnull(1) nonnull(3);
+
+static NSF_INLINE int
+PointerEntryValue(NsfPointerEntry *entryPtr, int generation, void **valuePtrPtr) {
+  int result;
+
+  nonnull_assert(entryPtr != NULL);
+  nonnull_assert(valuePtrPtr != NULL);
+
+#if defined(NSF_POINTER_ATOMIC)
+  if (__atomic_load_n(&entryPtr->generation, __ATOMIC_ACQUIRE) != generation) {
+    return 0;
+  }
+  *valuePtrPtr = __atomic_load_n(&entryPtr->valuePtr, __ATOMIC_ACQUIRE);
+  result = (__atomic_load_n(&entryPtr->generation, __ATOMIC_ACQUIRE) == generation);
+#else
+  NsfMutexLock(&pointerMutex);
+  *valuePtrPtr = entryPtr->valuePtr;
+  result = (entryPtr->generation == generation);
+  NsfMutexUnlock(&pointerMutex);
+#endif
+  return result;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PointerEntryInvalidate --
+ *
+ *      Invalidate a pointer entry, which was removed from the pointer
+ *      table, and push it to the free list. The function has to be
+ *      called under the pointerMutex.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Increments the generation of the entry, which invalidates the
+ *      cached lookups of its key.
+ *
+ *----------------------------------------------------------------------
+ */
+static void PointerEntryInvalidate(NsfPointerEntry *entryPtr) nonnull(1);
+
+static void
+PointerEntryInvalidate(NsfPointerEntry *entryPtr) {
+
+  nonnull_assert(entryPtr != NULL);
+
+  /*
+   * The new generation has to be visible before the valuePtr is
+   * changed, see PointerEntryValue().
+   */
+#if defined(NSF_POINTER_ATOMIC)
+  __atomic_store_n(&entryPtr->generation, entryPtr->generation + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&entryPtr->valuePtr, NULL, __ATOMIC_RELEASE);
+#else
+  entryPtr->generation++;
+  entryPtr->valuePtr = NULL;
+#endif
+  entryPtr->nextPtr = pointerFreeList;
+  pointerFreeList = entryPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * PointerFreeEntries --
+ *
+ *      Process exit handler freeing the pointer entries. The entries
+ *      cannot be freed earlier, since the internal representation of
+ *      Tcl_Objs might still refer to them.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Frees the entries in the free list.
+ *
+ *----------------------------------------------------------------------
+ */
+static void PointerFreeEntries(ClientData UNUSED(clientData));
+
+static void
+PointerFreeEntries(ClientData UNUSED(clientData)) {
+
+  NsfMutexLock(&pointerMutex);
+  while (pointerFreeList != NULL) {
+    NsfPointerEntry *entryPtr = pointerFreeList;
+
+    pointerFreeList = entryPtr->nextPtr;
+    ckfree((char *)entryPtr);
+  }
+  NsfMutexUnlock(&pointerMutex);
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -69,21 +227,33 @@ Nsf_PointerAdd(Tcl_Interp *interp, char *buffer, const char *typeName, void *val
 
   counterPtr = Nsf_PointerTypeLookup(interp, typeName);
   if (counterPtr != NULL) {
-    Tcl_DString ds, *dsPtr = &ds;
     Tcl_HashEntry *hPtr;
+    NsfPointerEntry *entryPtr;
     int isNew;
 
-    Tcl_DStringInit(dsPtr);
-    Tcl_DStringAppend(dsPtr, typeName, -1);
-    Tcl_DStringAppend(dsPtr, ":%d", 3);
     NsfMutexLock(&pointerMutex);
-    sprintf(buffer, Tcl_DStringValue(dsPtr), (*counterPtr)++);
+    if (pointerFreeList != NULL) {
+      entryPtr = pointerFreeList;
+      pointerFreeList = entryPtr->nextPtr;
+    } else {
+      /*
+       * Not counted via NEW(), since the entries outlive the
+       * interpreters (see PointerFreeEntries()).
+       */
+      entryPtr = (NsfPointerEntry *)ckalloc(sizeof(NsfPointerEntry));
+      entryPtr->generation = 0;
+    }
+#if defined(NSF_POINTER_ATOMIC)
+    __atomic_store_n(&entryPtr->valuePtr, valuePtr, __ATOMIC_RELEASE);
+#else
+    entryPtr->valuePtr = valuePtr;
+#endif
+    entryPtr->nextPtr = NULL;
+    sprintf(buffer, "%s:%d", typeName, (*counterPtr)++);
     hPtr = Tcl_CreateHashEntry(pointerHashTablePtr, buffer, &isNew);
+    Tcl_SetHashValue(hPtr, entryPtr);
     NsfMutexUnlock(&pointerMutex);
-    Tcl_SetHashValue(hPtr, valuePtr);
     /*fprintf(stderr, "Nsf_PointerAdd key '%s' prefix '%s' => %p value %p\n", buffer, typeName, hPtr, valuePtr);*/
-
-    Tcl_DStringFree(dsPtr);
   } else {
     return NsfPrintError(interp, "no type converter for %s registered", typeName);
   }
@@ -101,22 +271,29 @@ Nsf_PointerAdd(Tcl_Interp *interp, char *buffer, const char *typeName, void *val
  *      entry is obtained). If the prefix does not match, or there is no
  *      such entry in the table, the function returns NULL.
  *
+ *      The generation and the valuePtr of the entry at the time of
+ *      the lookup are returned in generationPtr and valuePtrPtr.
+ *
  * Results:
- *      valuePtr or NULL.
+ *      NsfPointerEntry or NULL.
  *
  * Side effects:
  *      None.
  *
  *----------------------------------------------------------------------
  */
-static void * Nsf_PointerGet(char *key, const char *prefix) nonnull(1) nonnull(2);
+static NsfPointerEntry * Nsf_PointerGet(char *key, const char *prefix, int *generationPtr,
+                                        void **valuePtrPtr)
+  nonnull(1) nonnull(2) nonnull(3) nonnull(4);
 
-static void *
-Nsf_PointerGet(char *key, const char *prefix) {
-  void *valuePtr = NULL;
+static NsfPointerEntry *
+Nsf_PointerGet(char *key, const char *prefix, int *generationPtr, void **valuePtrPtr) {
+  NsfPointerEntry *entryPtr = NULL;
 
   nonnull_assert(key != NULL);
   nonnull_assert(prefix != NULL);
+  nonnull_assert(generationPtr != NULL);
+  nonnull_assert(valuePtrPtr != NULL);
 
   /* make sure to return the right type of hash entry */
   if (strncmp(prefix, key, strlen(prefix)) == 0) {
@@ -126,11 +303,13 @@ Nsf_PointerGet(char *key, const char *prefix) {
     hPtr = Tcl_CreateHashEntry(pointerHashTablePtr, key, NULL);
 
     if (hPtr != NULL) {
-      valuePtr = Tcl_GetHashValue(hPtr);
+      entryPtr = Tcl_GetHashValue(hPtr);
+      *generationPtr = entryPtr->generation;
+      *valuePtrPtr = entryPtr->valuePtr;
     }
     NsfMutexUnlock(&pointerMutex);
   }
-  return valuePtr;
+  return entryPtr;
 }
 
 /*
@@ -164,8 +343,8 @@ Nsf_PointerGetHptr(void *valuePtr) {
 
   for (hPtr = Tcl_FirstHashEntry(pointerHashTablePtr, &hSrch); hPtr;
        hPtr = Tcl_NextHashEntry(&hSrch)) {
-    void *ptr = Tcl_GetHashValue(hPtr);
-    if (ptr == valuePtr) {
+    NsfPointerEntry *entryPtr = Tcl_GetHashValue(hPtr);
+    if (entryPtr->valuePtr == valuePtr) {
       return hPtr;
     }
   }
@@ -186,7 +365,8 @@ Nsf_PointerGetHptr(void *valuePtr) {
  *      valuePtr or NULL.
  *
  * Side effects:
- *      None.
+ *      Increments the generation of the entry, which invalidates the
+ *      cached lookups of the key.
  *
  *----------------------------------------------------------------------
  */
@@ -201,10 +381,13 @@ Nsf_PointerDelete(const char *key, void *valuePtr, int free) {
   hPtr = (key != NULL) ? Tcl_CreateHashEntry(pointerHashTablePtr, key, NULL)
     : Nsf_PointerGetHptr(valuePtr);
   if (hPtr != NULL) {
+    NsfPointerEntry *entryPtr = Tcl_GetHashValue(hPtr);
+
     if (free != 0) {
       ckfree((char *)valuePtr);
     }
     Tcl_DeleteHashEntry(hPtr);
+    PointerEntryInvalidate(entryPtr);
     result = TCL_OK;
   } else {
     result = TCL_ERROR;
@@ -222,7 +405,10 @@ Nsf_PointerDelete(const char *key, void *valuePtr, int free) {
  *    Nsf_TypeConverter setting the client data (passed to C functions)
  *    to the valuePtr of the opaque structure. This nsf type converter
  *    checks the passed value via the internally maintained pointer hash
- *    table.
+ *    table. The result of the lookup is cached in the Tcl_Obj, such
+ *    that later conversions of the same Tcl_Obj neither hash the key
+ *    nor lock the table, as long as the generation of the entry is
+ *    unchanged (i.e. the pointer was not deleted).
  *
  * Results:
  *    Tcl result code, *clientData and **outObjPtr
@@ -240,6 +426,7 @@ int Nsf_ConvertToPointer(Tcl_Interp *interp, Tcl_Obj *objPtr,  Nsf_Param const *
 int
 Nsf_ConvertToPointer(Tcl_Interp *interp, Tcl_Obj *objPtr,  Nsf_Param const *pPtr,
 		     ClientData *clientData, Tcl_Obj **outObjPtr) {
+  NsfPointerEntry *entryPtr;
   void *valuePtr;
 
   nonnull_assert(interp != NULL);
@@ -249,11 +436,28 @@ Nsf_ConvertToPointer(Tcl_Interp *interp, Tcl_Obj *objPtr,  Nsf_Param const *pPtr
   nonnull_assert(outObjPtr != NULL);
 
   *outObjPtr = objPtr;
-  valuePtr = Nsf_PointerGet(ObjStr(objPtr), pPtr->type);
-  if (valuePtr != NULL) {
+
+  if (objPtr->typePtr == &pointerObjType
+      && strncmp(pPtr->type, objPtr->bytes, strlen(pPtr->type)) == 0
+      && PointerEntryValue(objPtr->internalRep.twoPtrValue.ptr1,
+                           PTR2INT(objPtr->internalRep.twoPtrValue.ptr2), &valuePtr)) {
     *clientData = valuePtr;
     return TCL_OK;
   }
+  {
+    int generation;
+
+    entryPtr = Nsf_PointerGet(ObjStr(objPtr), pPtr->type, &generation, &valuePtr);
+    if (entryPtr != NULL) {
+      TclFreeIntRep(objPtr);
+      objPtr->internalRep.twoPtrValue.ptr1 = entryPtr;
+      objPtr->internalRep.twoPtrValue.ptr2 = INT2PTR(generation);
+      objPtr->typePtr = &pointerObjType;
+
+      *clientData = valuePtr;
+      return TCL_OK;
+    }
+  }
   return NsfObjErrType(interp, NULL, objPtr, pPtr->type, (Nsf_Param *)pPtr);
 }
 
@@ -283,7 +487,7 @@ Nsf_PointerTypeRegister(Tcl_Interp *interp, const char* typeName, int *counterPt
 
   NsfMutexLock(&pointerMutex);
 
-  hPtr = Tcl_CreateHashEntry(pointerHashTablePtr, typeName, &isNew);
+  hPtr = Tcl_CreateHashEntry(typeHashTablePtr, typeName, &isNew);
 
   NsfMutexUnlock(&pointerMutex);
 
@@ -319,7 +523,7 @@ Nsf_PointerTypeLookup(Tcl_Interp *interp, const char* typeName) {
   nonnull_assert(typeName != NULL);
 
   NsfMutexLock(&pointerMutex);
-  hPtr = Tcl_CreateHashEntry(pointerHashTablePtr, typeName, NULL);
+  hPtr = Tcl_CreateHashEntry(typeHashTablePtr, typeName, NULL);
   NsfMutexUnlock(&pointerMutex);
 
   if (hPtr != NULL) {
@@ -352,6 +556,11 @@ Nsf_PointerInit(Tcl_Interp *interp) {
 
   if (pointerTableRefCount == 0) {
     Tcl_InitHashTable(pointerHashTablePtr, TCL_STRING_KEYS);
+    Tcl_InitHashTable(typeHashTablePtr, TCL_STRING_KEYS);
+    if (pointerExitHandlerRegistered == 0) {
+      Tcl_CreateExitHandler(PointerFreeEntries, NULL);
+      pointerExitHandlerRegistered = 1;
+    }
   }
   pointerTableRefCount++;
 
@@ -371,7 +580,8 @@ Nsf_PointerInit(Tcl_Interp *interp) {
  *    void
  *
  * Side effects:
- *    None.
+ *    Deletes the pointer table, when the last interpreter exits. The
+ *    remaining entries are invalidated and kept in the free list.
  *
  *----------------------------------------------------------------------
  */
@@ -383,26 +593,30 @@ Nsf_PointerExit(Tcl_Interp *interp) {
 
   NsfMutexLock(&pointerMutex);
   if (--pointerTableRefCount == 0) {
+    Tcl_HashSearch hSrch;
+    Tcl_HashEntry *hPtr;
+    NsfPointerEntry *entryPtr;
 
-    if (RUNTIME_STATE(interp)->debugLevel >= 2) {
-      Tcl_HashSearch hSrch;
-      Tcl_HashEntry *hPtr;
+    for (hPtr = Tcl_FirstHashEntry(pointerHashTablePtr, &hSrch); hPtr;
+         hPtr = Tcl_NextHashEntry(&hSrch)) {
+      entryPtr = Tcl_GetHashValue(hPtr);
 
-      for (hPtr = Tcl_FirstHashEntry(pointerHashTablePtr, &hSrch); hPtr;
-	   hPtr = Tcl_NextHashEntry(&hSrch)) {
+      if (RUNTIME_STATE(interp)->debugLevel >= 2) {
 	char *key = Tcl_GetHashKey(pointerHashTablePtr, hPtr);
-	void *valuePtr = Tcl_GetHashValue(hPtr);
 
 	/*
 	 * We can't use NsfLog here any more, since the Tcl procs are
 	 * already deleted.
 	 */
 
-	fprintf(stderr, "Nsf_PointerExit: we have still an entry %s with value %p\n", key, valuePtr);
+	fprintf(stderr, "Nsf_PointerExit: we have still an entry %s with value %p\n",
+                key, entryPtr->valuePtr);
       }
+      PointerEntryInvalidate(entryPtr);
     }
 
     Tcl_DeleteHashTable(pointerHashTablePtr);
+    Tcl_DeleteHashTable(typeHashTablePtr);
   }
   /*fprintf(stderr, "Nsf_PointerExit pointerTableRefCount == %d\n", pointerTableRefCount);*/
 
@@ -36,21 +36,315 @@
  */
 
 #include "nsfInt.h"
+#include "nsfAccessInt.h"
 
 #if defined(NSF_PROFILE)
 
+/*
+ * Latency histograms use logarithmic buckets with linear sub-buckets
+ * (similar to HDR histograms): values below NSF_PROFILE_SUB_BUCKETS
+ * are counted exactly, larger values with a relative error of at most
+ * 1/NSF_PROFILE_SUB_BUCKETS. Values of 2^NSF_PROFILE_MAX_EXPONENT
+ * microseconds and more are counted in the last bucket. Histograms
+ * are kept for the method data only, since a histogram takes about
+ * 1KB.
+ */
+#define NSF_PROFILE_SUB_BUCKET_BITS 3
+#define NSF_PROFILE_SUB_BUCKETS (1 << NSF_PROFILE_SUB_BUCKET_BITS)
+#define NSF_PROFILE_MAX_EXPONENT 36
+#define NSF_PROFILE_BUCKETS ((NSF_PROFILE_MAX_EXPONENT - NSF_PROFILE_SUB_BUCKET_BITS + 1) * NSF_PROFILE_SUB_BUCKETS)
+
+typedef struct NsfProfileHistogram {
+  long max;
+  unsigned int buckets[NSF_PROFILE_BUCKETS];
+} NsfProfileHistogram;
+
 typedef struct NsfProfileData {
   long microSec;
   long count;
+  NsfProfileHistogram *histogram;
 } NsfProfileData;
 
+/*
+ * Key of the callData table used in the "pointers" mode. The
+ * commands and classes referenced from the keys are preserved as
+ * long as the entry exists; their number is bounded by the method
+ * definitions, not by the number of objects.
+ */
+typedef struct NsfProfileCallKey {
+  Tcl_Command cmd;
+  NsfClass *cl;
+  Tcl_Command callerCmd;
+  NsfClass *callerCl;
+} NsfProfileCallKey;
+
+#define NSF_PROFILE_CALLKEY_INTS ((int)(sizeof(NsfProfileCallKey) / sizeof(int)))
+
+/*
+ * Direct mapped cache in front of the callData and objectCallData
+ * tables: a hit returns the entries of both tables for a call
+ * without hashing the keys.
+ */
+#define NSF_PROFILE_CALLCACHE_SIZE 64
+
+typedef struct NsfProfileCallCacheEntry {
+  NsfProfileCallKey key;
+  NsfObject *object;
+  NsfProfileData *callValue;
+  NsfProfileData *objectValue;
+} NsfProfileCallCacheEntry;
+
+/*
+ * The objectCallData table used in the "pointers" mode, the
+ * counterpart of the objectData table of the "labels" mode, is keyed
+ * by the object; its values are tables keyed by the called cmd. The
+ * objects are not preserved: when an object is destroyed, its
+ * entries are moved to the objectData table (see
+ * NsfProfileObjectDelete()).
+ */
+
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileDataNew, NsfProfileDataFree --
+ *
+ *    Allocate and free profile data entries.
+ *
+ * Results:
+ *    New profile data or none
+ *
+ * Side effects:
+ *    Memory management
+ *
+ *----------------------------------------------------------------------
+ */
+static NsfProfileData *NsfProfileDataNew(void) returns_nonnull;
+
+static NsfProfileData *
+NsfProfileDataNew(void) {
+  NsfProfileData *value = (NsfProfileData *)ckalloc(sizeof(NsfProfileData));
+
+  value->microSec = 0;
+  value->count = 0;
+  value->histogram = NULL;
+  return value;
+}
+
+static void NsfProfileDataFree(NsfProfileData *value) nonnull(1);
+
+static void
+NsfProfileDataFree(NsfProfileData *value) {
+
+  nonnull_assert(value != NULL);
+
+  if (value->histogram != NULL) {
+    ckfree((char *)value->histogram);
+  }
+  ckfree((char *)value);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileBucket, NsfProfileBucketValue --
+ *
+ *    Map a latency to its histogram bucket, and a bucket to the
+ *    highest latency counted in it.
+ *
+ * Results:
+ *    Bucket index or latency in microseconds
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------
+ */
+static int NsfProfileBucket(long microSec);
+
+static int
+NsfProfileBucket(long microSec) {
+  int exponent;
+
+  if (microSec < NSF_PROFILE_SUB_BUCKETS) {
+    return microSec < 0 ? 0 : (int)microSec;
+  }
+  for (exponent = NSF_PROFILE_SUB_BUCKET_BITS; (microSec >> (exponent + 1)) != 0; exponent++) {
+    ;
+  }
+  if (exponent >= NSF_PROFILE_MAX_EXPONENT) {
+    return NSF_PROFILE_BUCKETS - 1;
+  }
+  return (exponent - NSF_PROFILE_SUB_BUCKET_BITS + 1) * NSF_PROFILE_SUB_BUCKETS
+    + (int)((microSec >> (exponent - NSF_PROFILE_SUB_BUCKET_BITS)) & (NSF_PROFILE_SUB_BUCKETS - 1));
+}
+
+static long NsfProfileBucketValue(int bucket);
+
+static long
+NsfProfileBucketValue(int bucket) {
+  int exponent;
+  long unit;
+
+  if (bucket < NSF_PROFILE_SUB_BUCKETS) {
+    return bucket;
+  }
+  exponent = bucket / NSF_PROFILE_SUB_BUCKETS + NSF_PROFILE_SUB_BUCKET_BITS - 1;
+  unit = 1L << (exponent - NSF_PROFILE_SUB_BUCKET_BITS);
+
+  return (NSF_PROFILE_SUB_BUCKETS + bucket % NSF_PROFILE_SUB_BUCKETS) * unit + unit - 1;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileBucketCheck --
+ *
+ *    Check the mapping of latencies to buckets at the boundaries of
+ *    all exponents: every latency has to be mapped to a valid bucket,
+ *    the buckets have to be ordered like the latencies, and every
+ *    bucket but the last one has to contain its latencies. The check
+ *    is available via nsf::__profile_check_histogram for the
+ *    regression test.
+ *
+ * Results:
+ *    Tcl result code.
+ *
+ * Side effects:
+ *    Sets an error message, when the mapping is broken.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+NsfProfileBucketCheck(Tcl_Interp *interp) {
+  int exponent, lastBucket = 0;
+
+  nonnull_assert(interp != NULL);
+
+  for (exponent = 0; exponent < (int)(sizeof(long) * 8) - 1; exponent++) {
+    long values[3];
+    int i;
+
+    values[0] = (1L << exponent) - 1;
+    values[1] = 1L << exponent;
+    values[2] = (1L << exponent) + ((1L << exponent) - 1);
+
+    for (i = 0; i < 3; i++) {
+      int bucket = NsfProfileBucket(values[i]);
+
+      if (bucket < lastBucket || bucket >= NSF_PROFILE_BUCKETS
+          || (bucket < NSF_PROFILE_BUCKETS - 1 && NsfProfileBucketValue(bucket) < values[i])) {
+        return NsfPrintError(interp, "latency %ld is mapped to invalid histogram bucket %d",
+                             values[i], bucket);
+      }
+      lastBucket = bucket;
+    }
+  }
+  if (NsfProfileBucket(LONG_MAX) != NSF_PROFILE_BUCKETS - 1) {
+    return NsfPrintError(interp, "maximum latency is not mapped to the last histogram bucket");
+  }
+  return TCL_OK;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileDataAdd --
+ *
+ *    Add a single measured latency to the profile data entry and,
+ *    when withHistogram is set, to its histogram.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated profile data entry, potentially allocated histogram.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileDataAdd(NsfProfileData *value, double totalMicroSec, int withHistogram) nonnull(1);
+
+static void
+NsfProfileDataAdd(NsfProfileData *value, double totalMicroSec, int withHistogram) {
+  NsfProfileHistogram *histogram;
+
+  nonnull_assert(value != NULL);
+
+  value->microSec += totalMicroSec;
+  value->count ++;
+
+  if (withHistogram == 0) {
+    return;
+  }
+  histogram = value->histogram;
+  if (histogram == NULL) {
+    histogram = (NsfProfileHistogram *)ckalloc(sizeof(NsfProfileHistogram));
+    memset(histogram, 0, sizeof(NsfProfileHistogram));
+    value->histogram = histogram;
+  }
+  histogram->buckets[NsfProfileBucket((long)totalMicroSec)] ++;
+  if ((long)totalMicroSec > histogram->max) {
+    histogram->max = (long)totalMicroSec;
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfilePercentiles --
+ *
+ *    Compute common percentiles from the histogram of a profile data
+ *    entry. The reported values are the upper bounds of the buckets,
+ *    limited by the maximum latency.
+ *
+ * Results:
+ *    Tcl dict with the keys p50, p90, p99, p99.9 and max
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *NsfProfilePercentiles(Tcl_Interp *interp, NsfProfileData *value) nonnull(1) nonnull(2);
+
+static Tcl_Obj *
+NsfProfilePercentiles(Tcl_Interp *interp, NsfProfileData *value) {
+  static const char *const names[] = {"p50", "p90", "p99", "p99.9"};
+  static const double fractions[] = {0.5, 0.9, 0.99, 0.999};
+  Tcl_Obj *dictObj = Tcl_NewDictObj();
+  NsfProfileHistogram *histogram = value->histogram;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(value != NULL);
+
+  if (histogram != NULL && value->count > 0) {
+    unsigned long seen = 0;
+    int bucket = 0, i;
+
+    for (i = 0; i < 4; i++) {
+      unsigned long rank = (unsigned long)(fractions[i] * (double)value->count + 0.5);
+      long result;
+
+      if (rank < 1) {
+        rank = 1;
+      }
+      while (bucket < NSF_PROFILE_BUCKETS && seen + histogram->buckets[bucket] < rank) {
+        seen += histogram->buckets[bucket];
+        bucket++;
+      }
+      result = NsfProfileBucketValue(bucket);
+      if (result > histogram->max) {
+        result = histogram->max;
+      }
+      Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj(names[i], -1), Tcl_NewLongObj(result));
+    }
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("max", 3), Tcl_NewLongObj(histogram->max));
+  }
+  return dictObj;
+}
 
 /*
  *----------------------------------------------------------------------
  * NsfProfileFillTable --
  *
  *    Insert or Update a keyed entry with provided microseconds and
- *    update the counts for this entry.
+ *    update the counts for this entry. When withHistogram is set, the
+ *    latency histogram of the entry is updated as well.
  *
  * Results:
  *    None
@@ -60,10 +354,13 @@ typedef struct NsfProfileData {
  *
  *----------------------------------------------------------------------
  */
-static void NsfProfileFillTable(Tcl_HashTable *table, const char *keyStr, double totalMicroSec) nonnull(1) nonnull(2);
+static void NsfProfileFillTable(Tcl_HashTable *table, const char *keyStr, double totalMicroSec,
+                                int withHistogram)
+  nonnull(1) nonnull(2);
 
 static void
-NsfProfileFillTable(Tcl_HashTable *table, const char *keyStr, double totalMicroSec) {
+NsfProfileFillTable(Tcl_HashTable *table, const char *keyStr, double totalMicroSec,
+                    int withHistogram) {
   NsfProfileData *value;
   Tcl_HashEntry *hPtr;
   int isNew;
@@ -73,15 +370,12 @@ NsfProfileFillTable(Tcl_HashTable *table, const char *keyStr, double totalMicroS
 
   hPtr = Tcl_CreateHashEntry(table, keyStr, &isNew);
   if (isNew != 0) {
-    value = (NsfProfileData *)ckalloc(sizeof(NsfProfileData));
-    value->microSec = 0;
-    value->count = 0;
+    value = NsfProfileDataNew();
     Tcl_SetHashValue(hPtr, (ClientData) value);
   } else {
     value = (NsfProfileData *)Tcl_GetHashValue (hPtr);
   }
-  value->microSec += totalMicroSec;
-  value->count ++;
+  NsfProfileDataAdd(value, totalMicroSec, withHistogram);
 }
 
 /*
@@ -131,7 +425,7 @@ Nsf_ProfileFilterObjCmd(ClientData cd, Tcl_Interp *interp, int objc, Tcl_Obj *CO
 
   NsfProfileTraceCallAppend(interp, label);
 
-  gettimeofday(&start, NULL);
+  NSF_PROFILE_GETTIME(&start);
   result = Tcl_NRCallObjProc(interp, ti->proc, ti->clientData, objc, objv);
   NsfProfileRecordProcData(interp, label, start.tv_sec, start.tv_usec);
 
@@ -487,7 +781,7 @@ NsfProfileTraceExit(Tcl_Interp *interp, NsfObject *object, NsfClass *cl, const c
     double totalMicroSec;
     struct timeval trt;
 
-    gettimeofday(&trt, NULL);
+    NSF_PROFILE_GETTIME(&trt);
     totalMicroSec = (trt.tv_sec - callTime->tv_sec) * 1000000 + (trt.tv_usec - callTime->tv_usec);
 
     Tcl_DStringInit(&ds);
@@ -509,137 +803,1371 @@ NsfProfileTraceExit(Tcl_Interp *interp, NsfObject *object, NsfClass *cl, const c
 
 /*
  *----------------------------------------------------------------------
- * NsfProfileRecordMethodData --
+ * NsfProfileFillCallTable --
  *
- *    This function is invoked, when a call of a method ends. It
- *    records profiling information based on the provided call stack
- *    content and the caller. In particular, it records the time spent
- *    in an object (identified with an objectKey) and the time spent
- *    in the method (using methodKey).
+ *    Return the entry of the callData table for a method call, which
+ *    is keyed by the pointers of the called cmd, its class and the
+ *    cmd and class of the caller. No strings are built; the cmds and
+ *    classes of new entries are preserved, such that the labels can
+ *    be computed later in NsfProfileGetData().
  *
  * Results:
- *    None
+ *    Profile data entry
  *
  * Side effects:
- *    Updated or created profile data entries
+ *    Updated or created profile data entry
  *
  *----------------------------------------------------------------------
  */
-void
-NsfProfileRecordMethodData(Tcl_Interp *interp, NsfCallStackContent *cscPtr) {
-  NsfRuntimeState *rst = RUNTIME_STATE(interp);
-  double totalMicroSec;
-  NsfObject *obj = cscPtr->self;
-  NsfClass *cl = cscPtr->cl;
-  Tcl_DString methodKey, objectKey, methodInfo;
-  NsfProfile *profilePtr = &rst->profile;
-  struct timeval trt;
+static NsfProfileData *NsfProfileFillCallTable(Tcl_HashTable *table, NsfProfileCallKey *keyPtr)
+  nonnull(1) nonnull(2) returns_nonnull;
 
-  nonnull_assert(interp != NULL);
-  nonnull_assert(cscPtr != NULL);
+static NsfProfileData *
+NsfProfileFillCallTable(Tcl_HashTable *table, NsfProfileCallKey *keyPtr) {
+  NsfProfileCallKey key = *keyPtr;
+  NsfProfileData *value;
+  Tcl_HashEntry *hPtr;
+  int isNew;
 
-  gettimeofday(&trt, NULL);
+  nonnull_assert(table != NULL);
+  nonnull_assert(keyPtr != NULL);
 
-  totalMicroSec = (trt.tv_sec - cscPtr->startSec) * 1000000 + (trt.tv_usec - cscPtr->startUsec);
-  profilePtr->overallTime += totalMicroSec;
+  hPtr = Tcl_CreateHashEntry(table, (char *)&key, &isNew);
+  if (isNew != 0) {
+    value = NsfProfileDataNew();
+    Tcl_SetHashValue(hPtr, (ClientData) value);
 
-  if (obj->teardown == 0 || !obj->id) {
-    return;
+    NsfCommandPreserve(key.cmd);
+    if (key.cl != NULL) {
+      NsfObjectRefCountIncr(&key.cl->object);
+    }
+    if (key.callerCmd != NULL) {
+      NsfCommandPreserve(key.callerCmd);
+    }
+    if (key.callerCl != NULL) {
+      NsfObjectRefCountIncr(&key.callerCl->object);
+    }
+  } else {
+    value = (NsfProfileData *)Tcl_GetHashValue (hPtr);
   }
+  return value;
+}
 
-  Tcl_DStringInit(&objectKey);
-  NsfProfileObjectLabel(&objectKey, obj, NULL, cscPtr->methodName);
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileFillObjectCallTable --
+ *
+ *    Return the entry of the objectCallData table for the object and
+ *    the called cmd. The cmds of new entries are preserved, the
+ *    object is not.
+ *
+ * Results:
+ *    Profile data entry
+ *
+ * Side effects:
+ *    Updated or created profile data entry
+ *
+ *----------------------------------------------------------------------
+ */
+static NsfProfileData *NsfProfileFillObjectCallTable(Tcl_HashTable *table, NsfObject *object,
+                                                     Tcl_Command cmd)
+  nonnull(1) nonnull(2) nonnull(3) returns_nonnull;
 
-  Tcl_DStringInit(&methodInfo);
-  Tcl_DStringInit(&methodKey);
-  NsfProfileMethodLabel(&methodInfo, obj, cl, cscPtr->methodName);
+static NsfProfileData *
+NsfProfileFillObjectCallTable(Tcl_HashTable *table, NsfObject *object, Tcl_Command cmd) {
+  Tcl_HashTable *cmdTable;
+  NsfProfileData *value;
+  Tcl_HashEntry *hPtr;
+  int isNew;
 
-  if (rst->doTrace) {
-    Tcl_DString traceKey;
+  nonnull_assert(table != NULL);
+  nonnull_assert(object != NULL);
+  nonnull_assert(cmd != NULL);
 
-    Tcl_DStringInit(&traceKey);
-    Tcl_DStringAppendElement(&traceKey, Tcl_DStringValue(&objectKey));
-    Tcl_DStringAppend(&traceKey, " ", 1);
-    Tcl_DStringAppendElement(&traceKey, Tcl_DStringValue(&methodInfo));
-    NsfProfileTraceExitAppend(interp, Tcl_DStringValue(&traceKey), totalMicroSec);
-    Tcl_DStringFree(&traceKey);
+  hPtr = Tcl_CreateHashEntry(table, (char *)object, &isNew);
+  if (isNew != 0) {
+    cmdTable = (Tcl_HashTable *)ckalloc(sizeof(Tcl_HashTable));
+    Tcl_InitHashTable(cmdTable, TCL_ONE_WORD_KEYS);
+    Tcl_SetHashValue(hPtr, (ClientData) cmdTable);
+  } else {
+    cmdTable = (Tcl_HashTable *)Tcl_GetHashValue(hPtr);
   }
 
-  /*
-   * Append method to object key as needed by statisitics (but not by trace)
-   */
-  Tcl_DStringAppendElement(&objectKey, cscPtr->methodName);
-
-  /*
-   * Build method key, containing actual method info and caller method info.
-   */
-  Tcl_DStringInit(&methodKey);
-  Tcl_DStringAppend(&methodKey, "{", 1);
-  Tcl_DStringAppend(&methodKey, Tcl_DStringValue(&methodInfo), Tcl_DStringLength(&methodInfo));
-  Tcl_DStringAppend(&methodKey, "}", 1);
-
-  {
-    NsfCallStackContent *cscPtrTop = NsfCallStackGetTopFrame(interp, NULL);
-    if (cscPtrTop != NULL) {
-      Tcl_DStringAppend(&methodKey, " {", 2);
-      NsfProfileMethodLabel(&methodKey, cscPtrTop->self, cscPtrTop->cl, cscPtrTop->methodName);
-      Tcl_DStringAppend(&methodKey, "}", 1);
-    } else {
-      Tcl_DStringAppend(&methodKey, " {}", 3);
-    }
+  hPtr = Tcl_CreateHashEntry(cmdTable, (char *)cmd, &isNew);
+  if (isNew != 0) {
+    value = NsfProfileDataNew();
+    Tcl_SetHashValue(hPtr, (ClientData) value);
+    NsfCommandPreserve(cmd);
+  } else {
+    value = (NsfProfileData *)Tcl_GetHashValue(hPtr);
   }
-
-  NsfProfileFillTable(&profilePtr->objectData, Tcl_DStringValue(&objectKey), totalMicroSec);
-  NsfProfileFillTable(&profilePtr->methodData, Tcl_DStringValue(&methodKey), totalMicroSec);
-  Tcl_DStringFree(&objectKey);
-  Tcl_DStringFree(&methodKey);
-  Tcl_DStringFree(&methodInfo);
+  return value;
 }
 
-
-
 /*
  *----------------------------------------------------------------------
- * NsfProfileRecordProcData --
+ * NsfProfileFillCallTables --
  *
- *    This function is invoked, when a call of a nsf::proc. It records
- *    time spent and count per nsf::proc.
+ *    Record the time spent in a method call in the callData and the
+ *    objectCallData tables. The entries of the tables are looked up
+ *    via the call cache, which is indexed by the pointers of the
+ *    object, the called cmd and the calling cmd.
  *
  * Results:
  *    None
  *
  * Side effects:
- *    Updated or created profile data entries
+ *    Updated or created profile data entries, updated call cache.
  *
  *----------------------------------------------------------------------
  */
-void
-NsfProfileRecordProcData(Tcl_Interp *interp, const char *methodName, long startSec, long startUsec) {
-  NsfRuntimeState *rst = RUNTIME_STATE(interp);
-  NsfProfile *profilePtr = &rst->profile;
-  double totalMicroSec;
-  struct timeval trt;
-
-  nonnull_assert(interp != NULL);
-  nonnull_assert(methodName != NULL);
+static void NsfProfileFillCallTables(Tcl_Interp *interp, NsfProfile *profilePtr,
+                                     NsfCallStackContent *cscPtr, double totalMicroSec)
+  nonnull(1) nonnull(2) nonnull(3);
 
-  gettimeofday(&trt, NULL);
+static void
+NsfProfileFillCallTables(Tcl_Interp *interp, NsfProfile *profilePtr,
+                         NsfCallStackContent *cscPtr, double totalMicroSec) {
+  NsfCallStackContent *cscPtrTop;
+  NsfProfileCallCacheEntry *entryPtr;
+  NsfProfileCallKey key;
+  NsfObject *object = cscPtr->self;
+  size_t index;
 
-  totalMicroSec = (trt.tv_sec - startSec) * 1000000 + (trt.tv_usec - startUsec);
-  profilePtr->overallTime += totalMicroSec;
+  nonnull_assert(interp != NULL);
+  nonnull_assert(profilePtr != NULL);
+  nonnull_assert(cscPtr != NULL);
 
-  if (rst->doTrace) {
-    NsfProfileTraceExitAppend(interp, methodName, totalMicroSec);
+  memset(&key, 0, sizeof(key));
+  key.cmd = cscPtr->cmdPtr;
+  key.cl = cscPtr->cl;
+  cscPtrTop = NsfCallStackGetTopFrame(interp, NULL);
+  if (cscPtrTop != NULL) {
+    key.callerCmd = cscPtrTop->cmdPtr;
+    key.callerCl = cscPtrTop->cl;
   }
 
-  NsfProfileFillTable(&profilePtr->procData, methodName, totalMicroSec);
+  index = (((size_t)object >> 4) ^ ((size_t)key.cmd >> 4) ^ ((size_t)key.callerCmd >> 6))
+    & (NSF_PROFILE_CALLCACHE_SIZE - 1);
+  entryPtr = &profilePtr->callCache[index];
+
+  if (entryPtr->object != object || entryPtr->callValue == NULL
+      || memcmp(&entryPtr->key, &key, sizeof(key)) != 0) {
+    entryPtr->key = key;
+    entryPtr->object = object;
+    entryPtr->callValue = NsfProfileFillCallTable(&profilePtr->callData, &key);
+    entryPtr->objectValue = NsfProfileFillObjectCallTable(&profilePtr->objectCallData,
+                                                          object, key.cmd);
+  }
+  NsfProfileDataAdd(entryPtr->callValue, totalMicroSec, 1);
+  NsfProfileDataAdd(entryPtr->objectValue, totalMicroSec, 0);
 }
 
 /*
  *----------------------------------------------------------------------
- * NsfProfileClearTable --
+ * NsfProfileCallLabel --
  *
- *    Clear all data in a profile table.
+ *    Produce the label for a method identified by a cmd and a class,
+ *    in the same format as NsfProfileMethodLabel(). Deleted cmds
+ *    and classes are reported as such.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Appends to the passed DString.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileCallLabel(Tcl_Interp *interp, Tcl_DString *dsPtr, Tcl_Command cmd, NsfClass *cl)
+  nonnull(1) nonnull(2);
+
+static void
+NsfProfileCallLabel(Tcl_Interp *interp, Tcl_DString *dsPtr, Tcl_Command cmd, NsfClass *cl) {
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(dsPtr != NULL);
+
+  if (cl != NULL) {
+    if ((cl->object.flags & NSF_DELETED) != 0u) {
+      Tcl_DStringAppend(dsPtr, "<deleted>", -1);
+    } else {
+      Tcl_DStringAppend(dsPtr, ObjStr(cl->object.cmdName), -1);
+    }
+    Tcl_DStringAppend(dsPtr, " ", 1);
+  }
+  if (cmd == NULL) {
+    Tcl_DStringAppendElement(dsPtr, "");
+  } else if ((Tcl_Command_flags(cmd) & CMD_IS_DELETED) != 0u) {
+    Tcl_DStringAppendElement(dsPtr, "<deleted>");
+  } else {
+    Tcl_DStringAppendElement(dsPtr, Tcl_GetCommandName(interp, cmd));
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileSumTable --
+ *
+ *    Add the provided profile data to the entry with the given key
+ *    in a string keyed profile table.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated or created profile data entry
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileSumTable(Tcl_HashTable *table, const char *keyStr, NsfProfileData *data)
+  nonnull(1) nonnull(2) nonnull(3);
+
+static void
+NsfProfileSumTable(Tcl_HashTable *table, const char *keyStr, NsfProfileData *data) {
+  NsfProfileData *value;
+  Tcl_HashEntry *hPtr;
+  int isNew;
+
+  nonnull_assert(table != NULL);
+  nonnull_assert(keyStr != NULL);
+  nonnull_assert(data != NULL);
+
+  hPtr = Tcl_CreateHashEntry(table, keyStr, &isNew);
+  if (isNew != 0) {
+    value = NsfProfileDataNew();
+    Tcl_SetHashValue(hPtr, (ClientData) value);
+  } else {
+    value = (NsfProfileData *)Tcl_GetHashValue(hPtr);
+  }
+  value->microSec += data->microSec;
+  value->count += data->count;
+
+  if (data->histogram != NULL) {
+    int i;
+
+    if (value->histogram == NULL) {
+      value->histogram = (NsfProfileHistogram *)ckalloc(sizeof(NsfProfileHistogram));
+      memset(value->histogram, 0, sizeof(NsfProfileHistogram));
+    }
+    for (i = 0; i < NSF_PROFILE_BUCKETS; i++) {
+      value->histogram->buckets[i] += data->histogram->buckets[i];
+    }
+    if (data->histogram->max > value->histogram->max) {
+      value->histogram->max = data->histogram->max;
+    }
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileMergeTable --
+ *
+ *    Add all entries of a string keyed profile table to another
+ *    string keyed profile table.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated or created profile data entries
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileMergeTable(Tcl_HashTable *table, Tcl_HashTable *sourceTable)
+  nonnull(1) nonnull(2);
+
+static void
+NsfProfileMergeTable(Tcl_HashTable *table, Tcl_HashTable *sourceTable) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(table != NULL);
+  nonnull_assert(sourceTable != NULL);
+
+  for (hPtr = Tcl_FirstHashEntry(sourceTable, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    NsfProfileSumTable(table, Tcl_GetHashKey(sourceTable, hPtr),
+                       (NsfProfileData *)Tcl_GetHashValue(hPtr));
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileCallTableToMethodData --
+ *
+ *    Aggregate the entries of the pointer keyed callData table into
+ *    the provided string keyed table, using the same keys as the
+ *    methodData table in the "labels" mode.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Fills the passed table.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileCallTableToMethodData(Tcl_Interp *interp, Tcl_HashTable *callTable,
+                                            Tcl_HashTable *methodTable)
+  nonnull(1) nonnull(2) nonnull(3);
+
+static void
+NsfProfileCallTableToMethodData(Tcl_Interp *interp, Tcl_HashTable *callTable,
+                                Tcl_HashTable *methodTable) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+  Tcl_DString methodKey;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(callTable != NULL);
+  nonnull_assert(methodTable != NULL);
+
+  Tcl_DStringInit(&methodKey);
+  for (hPtr = Tcl_FirstHashEntry(callTable, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    NsfProfileCallKey *keyPtr = (NsfProfileCallKey *)Tcl_GetHashKey(callTable, hPtr);
+    NsfProfileData *value = (NsfProfileData *)Tcl_GetHashValue(hPtr);
+
+    Tcl_DStringTrunc(&methodKey, 0);
+    Tcl_DStringAppend(&methodKey, "{", 1);
+    NsfProfileCallLabel(interp, &methodKey, keyPtr->cmd, keyPtr->cl);
+    Tcl_DStringAppend(&methodKey, "} {", 3);
+    if (keyPtr->callerCmd != NULL) {
+      NsfProfileCallLabel(interp, &methodKey, keyPtr->callerCmd, keyPtr->callerCl);
+    }
+    Tcl_DStringAppend(&methodKey, "}", 1);
+
+    NsfProfileSumTable(methodTable, Tcl_DStringValue(&methodKey), value);
+  }
+  Tcl_DStringFree(&methodKey);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileObjectCallsToObjectData --
+ *
+ *    Add the entries of the cmd table of an object in the
+ *    objectCallData table to the provided string keyed table, using
+ *    the same keys as the objectData table in the "labels" mode.
+ *    When "release" is true, the cmd table is emptied, and the cmds
+ *    are released.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Fills the passed table.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileObjectCallsToObjectData(Tcl_Interp *interp, NsfObject *object,
+                                              Tcl_HashTable *cmdTable, Tcl_HashTable *objectTable,
+                                              int release)
+  nonnull(1) nonnull(2) nonnull(3) nonnull(4);
+
+static void
+NsfProfileObjectCallsToObjectData(Tcl_Interp *interp, NsfObject *object,
+                                  Tcl_HashTable *cmdTable, Tcl_HashTable *objectTable,
+                                  int release) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+  Tcl_DString objectKey;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(object != NULL);
+  nonnull_assert(cmdTable != NULL);
+  nonnull_assert(objectTable != NULL);
+
+  Tcl_DStringInit(&objectKey);
+  for (hPtr = Tcl_FirstHashEntry(cmdTable, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    Tcl_Command cmd = (Tcl_Command)Tcl_GetHashKey(cmdTable, hPtr);
+    NsfProfileData *value = (NsfProfileData *)Tcl_GetHashValue(hPtr);
+
+    Tcl_DStringTrunc(&objectKey, 0);
+    if ((object->flags & NSF_DELETED) != 0u || object->teardown == NULL) {
+      Tcl_DStringAppend(&objectKey, "<deleted> <deleted>", -1);
+    } else {
+      NsfProfileObjectLabel(&objectKey, object, NULL, "");
+    }
+    if ((Tcl_Command_flags(cmd) & CMD_IS_DELETED) != 0u) {
+      Tcl_DStringAppendElement(&objectKey, "<deleted>");
+    } else {
+      Tcl_DStringAppendElement(&objectKey, Tcl_GetCommandName(interp, cmd));
+    }
+
+    NsfProfileSumTable(objectTable, Tcl_DStringValue(&objectKey), value);
+
+    if (release != 0) {
+      NsfCommandRelease(cmd);
+      NsfProfileDataFree(value);
+      Tcl_DeleteHashEntry(hPtr);
+    }
+  }
+  Tcl_DStringFree(&objectKey);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileObjectCallTableToObjectData --
+ *
+ *    Aggregate the entries of the pointer keyed objectCallData table
+ *    into the provided string keyed table, using the same keys as the
+ *    objectData table in the "labels" mode.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Fills the passed table.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileObjectCallTableToObjectData(Tcl_Interp *interp, Tcl_HashTable *callTable,
+                                                  Tcl_HashTable *objectTable)
+  nonnull(1) nonnull(2) nonnull(3);
+
+static void
+NsfProfileObjectCallTableToObjectData(Tcl_Interp *interp, Tcl_HashTable *callTable,
+                                      Tcl_HashTable *objectTable) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(callTable != NULL);
+  nonnull_assert(objectTable != NULL);
+
+  for (hPtr = Tcl_FirstHashEntry(callTable, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    NsfProfileObjectCallsToObjectData(interp, (NsfObject *)Tcl_GetHashKey(callTable, hPtr),
+                                      (Tcl_HashTable *)Tcl_GetHashValue(hPtr), objectTable, 0);
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileObjectDelete --
+ *
+ *    Called, when an object is destroyed: move the entries of the
+ *    object in the objectCallData table to the string keyed
+ *    objectData table, such that the objectCallData table and the
+ *    call cache do not refer to freed objects and the data of the
+ *    object is kept.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updates the profile tables.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileObjectDelete(Tcl_Interp *interp, NsfObject *object) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  Tcl_HashTable *cmdTable;
+  Tcl_HashEntry *hPtr;
+  int i;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(object != NULL);
+
+  if (likely(profilePtr->objectCallData.numEntries == 0)) {
+    return;
+  }
+  hPtr = Tcl_FindHashEntry(&profilePtr->objectCallData, (char *)object);
+  if (hPtr == NULL) {
+    return;
+  }
+  for (i = 0; i < NSF_PROFILE_CALLCACHE_SIZE; i++) {
+    if (profilePtr->callCache[i].object == object) {
+      profilePtr->callCache[i].callValue = NULL;
+      profilePtr->callCache[i].object = NULL;
+    }
+  }
+  cmdTable = (Tcl_HashTable *)Tcl_GetHashValue(hPtr);
+  NsfProfileObjectCallsToObjectData(interp, object, cmdTable, &profilePtr->objectData, 1);
+  Tcl_DeleteHashTable(cmdTable);
+  ckfree((char *)cmdTable);
+  Tcl_DeleteHashEntry(hPtr);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileClearCallTable, NsfProfileClearObjectCallTable --
+ *
+ *    Clear all data in the pointer keyed callData or objectCallData
+ *    table and release the cmds and classes referenced from the keys.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    freed profile information.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileClearCallTable(Tcl_HashTable *table) nonnull(1);
+
+static void
+NsfProfileClearCallTable(Tcl_HashTable *table) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(table != NULL);
+
+  for (hPtr = Tcl_FirstHashEntry(table, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    NsfProfileCallKey *keyPtr = (NsfProfileCallKey *)Tcl_GetHashKey(table, hPtr);
+
+    NsfCommandRelease(keyPtr->cmd);
+    if (keyPtr->cl != NULL) {
+      NsfCleanupObject(&keyPtr->cl->object, "NsfProfileClearCallTable");
+    }
+    if (keyPtr->callerCmd != NULL) {
+      NsfCommandRelease(keyPtr->callerCmd);
+    }
+    if (keyPtr->callerCl != NULL) {
+      NsfCleanupObject(&keyPtr->callerCl->object, "NsfProfileClearCallTable");
+    }
+    NsfProfileDataFree((NsfProfileData *)Tcl_GetHashValue(hPtr));
+    Tcl_DeleteHashEntry(hPtr);
+  }
+}
+
+static void NsfProfileClearObjectCallTable(Tcl_HashTable *table) nonnull(1);
+
+static void
+NsfProfileClearObjectCallTable(Tcl_HashTable *table) {
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(table != NULL);
+
+  for (hPtr = Tcl_FirstHashEntry(table, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    Tcl_HashTable *cmdTable = (Tcl_HashTable *)Tcl_GetHashValue(hPtr);
+    Tcl_HashSearch cmdSrch;
+    Tcl_HashEntry *cmdHPtr;
+
+    for (cmdHPtr = Tcl_FirstHashEntry(cmdTable, &cmdSrch); cmdHPtr;
+         cmdHPtr = Tcl_NextHashEntry(&cmdSrch)) {
+      NsfCommandRelease((Tcl_Command)Tcl_GetHashKey(cmdTable, cmdHPtr));
+      NsfProfileDataFree((NsfProfileData *)Tcl_GetHashValue(cmdHPtr));
+    }
+    Tcl_DeleteHashTable(cmdTable);
+    ckfree((char *)cmdTable);
+    Tcl_DeleteHashEntry(hPtr);
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileSetMode --
+ *
+ *    Set the profile mode to NSF_PROFILE_MODE_LABELS or
+ *    NSF_PROFILE_MODE_POINTERS. The data collected so far is kept.
+ *
+ * Results:
+ *    Previous profile mode
+ *
+ * Side effects:
+ *    Updates profilePtr->mode
+ *
+ *----------------------------------------------------------------------
+ */
+int
+NsfProfileSetMode(Tcl_Interp *interp, int mode) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  int oldMode;
+
+  nonnull_assert(interp != NULL);
+
+  oldMode = profilePtr->mode;
+  profilePtr->mode = mode;
+
+  return oldMode;
+}
+
+/*
+ * State of the sampling profiler. In threaded builds, a separate
+ * timer thread marks an async handler every "interval" milliseconds,
+ * and the handler records the NSF call stack of the interp at the next
+ * safe point in the interp's thread. Without thread support, a timer
+ * handler is used, which fires only when the event loop is serviced.
+ */
+typedef struct NsfProfileSampler {
+  Tcl_Interp *interp;
+  int interval;
+#if defined(TCL_THREADS)
+  Tcl_AsyncHandler asyncHandler;
+  Tcl_ThreadId threadId;
+  volatile int stop;
+#else
+  Tcl_TimerToken timerToken;
+#endif
+} NsfProfileSampler;
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileTakeSample --
+ *
+ *    Record the current NSF call stack of the interp as a folded
+ *    stack in the sampleData table.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated or created sample entry
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileTakeSample(NsfProfileSampler *samplerPtr) nonnull(1);
+
+static void
+NsfProfileTakeSample(NsfProfileSampler *samplerPtr) {
+  Tcl_Interp *interp = samplerPtr->interp;
+  Tcl_DString ds;
+
+  nonnull_assert(samplerPtr != NULL);
+
+  Tcl_DStringInit(&ds);
+  if (NsfCallStackFolded(interp, &ds) > 0) {
+    NsfProfileData sample;
+
+    sample.microSec = samplerPtr->interval * 1000L;
+    sample.count = 1;
+    sample.histogram = NULL;
+    NsfProfileSumTable(&RUNTIME_STATE(interp)->profile.sampleData, Tcl_DStringValue(&ds), &sample);
+  }
+  Tcl_DStringFree(&ds);
+}
+
+#if defined(TCL_THREADS)
+static int NsfProfileSampleAsyncProc(ClientData clientData, Tcl_Interp *UNUSED(interp), int code)
+  nonnull(1);
+
+static int
+NsfProfileSampleAsyncProc(ClientData clientData, Tcl_Interp *UNUSED(interp), int code) {
+
+  nonnull_assert(clientData != NULL);
+
+  NsfProfileTakeSample((NsfProfileSampler *)clientData);
+  return code;
+}
+
+static Tcl_ThreadCreateType NsfProfileSampleThread(ClientData clientData) nonnull(1);
+
+static Tcl_ThreadCreateType
+NsfProfileSampleThread(ClientData clientData) {
+  NsfProfileSampler *samplerPtr = (NsfProfileSampler *)clientData;
+
+  nonnull_assert(clientData != NULL);
+
+  while (samplerPtr->stop == 0) {
+    Tcl_Sleep(samplerPtr->interval);
+    if (samplerPtr->stop == 0) {
+      Tcl_AsyncMark(samplerPtr->asyncHandler);
+    }
+  }
+  TCL_THREAD_CREATE_RETURN;
+}
+#else
+static void NsfProfileSampleTimerProc(ClientData clientData) nonnull(1);
+
+static void
+NsfProfileSampleTimerProc(ClientData clientData) {
+  NsfProfileSampler *samplerPtr = (NsfProfileSampler *)clientData;
+
+  nonnull_assert(clientData != NULL);
+
+  NsfProfileTakeSample(samplerPtr);
+  samplerPtr->timerToken = Tcl_CreateTimerHandler(samplerPtr->interval,
+                                                  NsfProfileSampleTimerProc, samplerPtr);
+}
+#endif
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileSample --
+ *
+ *    Start or stop the sampling profiler. When started, the NSF call
+ *    stack is recorded every "interval" milliseconds; the collected
+ *    samples can be obtained via NsfProfileGetSamples() and are
+ *    flushed by NsfProfileClearData().
+ *
+ * Results:
+ *    Previous sampling state (0 or 1)
+ *
+ * Side effects:
+ *    Creates or terminates the sampler.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+NsfProfileSample(Tcl_Interp *interp, int withEnable, int interval) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  NsfProfileSampler *samplerPtr = profilePtr->sampler;
+  int oldState = (samplerPtr != NULL);
+
+  nonnull_assert(interp != NULL);
+
+  if (samplerPtr != NULL) {
+#if defined(TCL_THREADS)
+    int result;
+
+    samplerPtr->stop = 1;
+    Tcl_JoinThread(samplerPtr->threadId, &result);
+    Tcl_AsyncDelete(samplerPtr->asyncHandler);
+#else
+    Tcl_DeleteTimerHandler(samplerPtr->timerToken);
+#endif
+    ckfree((char *)samplerPtr);
+    profilePtr->sampler = NULL;
+  }
+
+  if (withEnable != 0) {
+    samplerPtr = (NsfProfileSampler *)ckalloc(sizeof(NsfProfileSampler));
+    samplerPtr->interp = interp;
+    samplerPtr->interval = interval > 0 ? interval : 1;
+#if defined(TCL_THREADS)
+    samplerPtr->stop = 0;
+    samplerPtr->asyncHandler = Tcl_AsyncCreate(NsfProfileSampleAsyncProc, samplerPtr);
+    if (Tcl_CreateThread(&samplerPtr->threadId, NsfProfileSampleThread, samplerPtr,
+                         TCL_THREAD_STACK_DEFAULT, TCL_THREAD_JOINABLE) != TCL_OK) {
+      Tcl_AsyncDelete(samplerPtr->asyncHandler);
+      ckfree((char *)samplerPtr);
+      return oldState;
+    }
+#else
+    samplerPtr->timerToken = Tcl_CreateTimerHandler(samplerPtr->interval,
+                                                    NsfProfileSampleTimerProc, samplerPtr);
+#endif
+    profilePtr->sampler = samplerPtr;
+  }
+
+  return oldState;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileGetSamples --
+ *
+ *    Return the samples collected by the sampling profiler as folded
+ *    stacks, one line per distinct stack followed by the number of
+ *    samples, as consumed by flamegraph tools.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Sets the interp result.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileGetSamples(Tcl_Interp *interp) {
+  Tcl_HashTable *table = &RUNTIME_STATE(interp)->profile.sampleData;
+  Tcl_Obj *resultObj = Tcl_NewObj();
+  Tcl_HashSearch hSrch;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(interp != NULL);
+
+  for (hPtr = Tcl_FirstHashEntry(table, &hSrch); hPtr;
+       hPtr = Tcl_NextHashEntry(&hSrch)) {
+    NsfProfileData *value = (NsfProfileData *) Tcl_GetHashValue(hPtr);
+
+    Tcl_AppendPrintfToObj(resultObj, "%s %ld\n", (char *)Tcl_GetHashKey(table, hPtr), value->count);
+  }
+  Tcl_SetObjResult(interp, resultObj);
+}
+
+/*
+ * Node of the call graph profile. Every node represents a method
+ * invocation in the context of its callers (a path in the call tree);
+ * the cmds and classes of the nodes are preserved until the nodes are
+ * freed. Clearing the profile data resets the counters only, since
+ * active call stack entries might refer to the nodes.
+ */
+typedef struct NsfProfileNode {
+  Tcl_Command cmd;
+  NsfClass *cl;
+  unsigned short frameType;
+  long count;
+  long selfMicroSec;
+  long inclusiveMicroSec;
+  long maxMicroSec;
+  struct NsfProfileNode *firstChild;
+  struct NsfProfileNode *nextSibling;
+} NsfProfileNode;
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileNodeChild --
+ *
+ *    Return the child node of the provided node for the given method,
+ *    class and frame type. If no such child exists, it is created.
+ *
+ * Results:
+ *    Profile node
+ *
+ * Side effects:
+ *    Potentially allocates a node and preserves its cmd and class.
+ *
+ *----------------------------------------------------------------------
+ */
+static NsfProfileNode *NsfProfileNodeChild(NsfProfileNode *parentPtr, Tcl_Command cmd, NsfClass *cl,
+                                           unsigned short frameType)
+  nonnull(1) nonnull(2) returns_nonnull;
+
+static NsfProfileNode *
+NsfProfileNodeChild(NsfProfileNode *parentPtr, Tcl_Command cmd, NsfClass *cl, unsigned short frameType) {
+  NsfProfileNode *nodePtr;
+
+  nonnull_assert(parentPtr != NULL);
+  nonnull_assert(cmd != NULL);
+
+  for (nodePtr = parentPtr->firstChild; nodePtr != NULL; nodePtr = nodePtr->nextSibling) {
+    if (nodePtr->cmd == cmd && nodePtr->cl == cl && nodePtr->frameType == frameType) {
+      return nodePtr;
+    }
+  }
+
+  nodePtr = (NsfProfileNode *)ckalloc(sizeof(NsfProfileNode));
+  memset(nodePtr, 0, sizeof(NsfProfileNode));
+  nodePtr->cmd = cmd;
+  nodePtr->cl = cl;
+  nodePtr->frameType = frameType;
+  nodePtr->nextSibling = parentPtr->firstChild;
+  parentPtr->firstChild = nodePtr;
+
+  NsfCommandPreserve(cmd);
+  if (cl != NULL) {
+    NsfObjectRefCountIncr(&cl->object);
+  }
+  return nodePtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileNodeFree, NsfProfileNodeReset --
+ *
+ *    Free the provided node with all its descendants, or reset the
+ *    counters of these nodes.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Frees memory or resets counters.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileNodeFree(NsfProfileNode *nodePtr) nonnull(1);
+
+static void
+NsfProfileNodeFree(NsfProfileNode *nodePtr) {
+  NsfProfileNode *childPtr, *nextPtr;
+
+  nonnull_assert(nodePtr != NULL);
+
+  for (childPtr = nodePtr->firstChild; childPtr != NULL; childPtr = nextPtr) {
+    nextPtr = childPtr->nextSibling;
+    NsfProfileNodeFree(childPtr);
+  }
+  if (nodePtr->cmd != NULL) {
+    NsfCommandRelease(nodePtr->cmd);
+  }
+  if (nodePtr->cl != NULL) {
+    NsfCleanupObject(&nodePtr->cl->object, "NsfProfileNodeFree");
+  }
+  ckfree((char *)nodePtr);
+}
+
+static void NsfProfileNodeReset(NsfProfileNode *nodePtr) nonnull(1);
+
+static void
+NsfProfileNodeReset(NsfProfileNode *nodePtr) {
+  NsfProfileNode *childPtr;
+
+  nonnull_assert(nodePtr != NULL);
+
+  for (childPtr = nodePtr->firstChild; childPtr != NULL; childPtr = childPtr->nextSibling) {
+    NsfProfileNodeReset(childPtr);
+  }
+  nodePtr->count = 0;
+  nodePtr->selfMicroSec = 0;
+  nodePtr->inclusiveMicroSec = 0;
+  nodePtr->maxMicroSec = 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileCscNode --
+ *
+ *    Return the call graph node of the method invocation represented
+ *    by the provided call stack content. The node is determined from
+ *    the node of the calling method, which is resolved (and cached in
+ *    the call stack content) on demand, such that every frame is
+ *    resolved at most once. The frame of the caller is searched
+ *    starting from callerFramePtr.
+ *
+ * Results:
+ *    Profile node
+ *
+ * Side effects:
+ *    Sets cscPtr->profileNode, potentially creates nodes.
+ *
+ *----------------------------------------------------------------------
+ */
+static NsfProfileNode *NsfProfileCscNode(NsfProfileNode *rootPtr, NsfCallStackContent *cscPtr,
+                                         Tcl_CallFrame *callerFramePtr)
+  nonnull(1) nonnull(2) returns_nonnull;
+
+static NsfProfileNode *
+NsfProfileCscNode(NsfProfileNode *rootPtr, NsfCallStackContent *cscPtr, Tcl_CallFrame *callerFramePtr) {
+
+  nonnull_assert(rootPtr != NULL);
+  nonnull_assert(cscPtr != NULL);
+
+  if (cscPtr->profileNode == NULL) {
+    Tcl_CallFrame *framePtr = NsfCallStackNextMethodFrame(callerFramePtr);
+    NsfProfileNode *parentPtr = rootPtr;
+
+    if (framePtr != NULL) {
+      NsfCallStackContent *callerCscPtr = (NsfCallStackContent *)Tcl_CallFrame_clientData(framePtr);
+
+      if (callerCscPtr->cmdPtr != NULL) {
+        parentPtr = NsfProfileCscNode(rootPtr, callerCscPtr, Tcl_CallFrame_callerPtr(framePtr));
+      }
+    }
+    cscPtr->profileNode = NsfProfileNodeChild(parentPtr, cscPtr->cmdPtr, cscPtr->cl,
+                                              cscPtr->frameType & ~NSF_CSC_TYPE_INACTIVE);
+  }
+  return cscPtr->profileNode;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileRecordCallGraph --
+ *
+ *    Record a finished method invocation in the call graph profile.
+ *    The self time is the inclusive time minus the inclusive time of
+ *    the invocations made from this method, which are accumulated in
+ *    the call stack content.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated profile node, updated childMicroSec of the caller.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileRecordCallGraph(Tcl_Interp *interp, NsfCallStackContent *cscPtr, long totalMicroSec)
+  nonnull(1) nonnull(2);
+
+static void
+NsfProfileRecordCallGraph(Tcl_Interp *interp, NsfCallStackContent *cscPtr, long totalMicroSec) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  Tcl_CallFrame *framePtr;
+  NsfProfileNode *nodePtr;
+  long selfMicroSec;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(cscPtr != NULL);
+
+  /*
+   * The frame of the finished method might be still on the stack.
+   */
+  framePtr = NsfCallStackNextMethodFrame((Tcl_CallFrame *)Tcl_Interp_framePtr(interp));
+  if (framePtr != NULL && (NsfCallStackContent *)Tcl_CallFrame_clientData(framePtr) == cscPtr) {
+    framePtr = NsfCallStackNextMethodFrame(Tcl_CallFrame_callerPtr(framePtr));
+  }
+
+  if (profilePtr->callGraph == NULL) {
+    profilePtr->callGraph = (NsfProfileNode *)ckalloc(sizeof(NsfProfileNode));
+    memset(profilePtr->callGraph, 0, sizeof(NsfProfileNode));
+  }
+  nodePtr = NsfProfileCscNode(profilePtr->callGraph, cscPtr, framePtr);
+
+  selfMicroSec = totalMicroSec - cscPtr->childMicroSec;
+  if (selfMicroSec < 0) {
+    selfMicroSec = 0;
+  }
+  nodePtr->count ++;
+  nodePtr->selfMicroSec += selfMicroSec;
+  nodePtr->inclusiveMicroSec += totalMicroSec;
+  if (totalMicroSec > nodePtr->maxMicroSec) {
+    nodePtr->maxMicroSec = totalMicroSec;
+  }
+
+  if (framePtr != NULL) {
+    NsfCallStackContent *callerCscPtr = (NsfCallStackContent *)Tcl_CallFrame_clientData(framePtr);
+    callerCscPtr->childMicroSec += totalMicroSec;
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileCallGraph --
+ *
+ *    Turn recording of the call graph profile on or off. The call
+ *    graph is recorded while profiling is enabled.
+ *
+ * Results:
+ *    Previous state
+ *
+ * Side effects:
+ *    Updates profilePtr->doCallGraph
+ *
+ *----------------------------------------------------------------------
+ */
+int
+NsfProfileCallGraph(Tcl_Interp *interp, int withEnable) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  int oldState;
+
+  nonnull_assert(interp != NULL);
+
+  oldState = profilePtr->doCallGraph;
+  profilePtr->doCallGraph = withEnable;
+
+  return oldState;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileNodeLabel --
+ *
+ *    Append the label of a call graph node to a DString; mixin and
+ *    filter invocations are marked as such.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Appends to the DString.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileNodeLabel(Tcl_Interp *interp, Tcl_DString *dsPtr, NsfProfileNode *nodePtr)
+  nonnull(1) nonnull(2) nonnull(3);
+
+static void
+NsfProfileNodeLabel(Tcl_Interp *interp, Tcl_DString *dsPtr, NsfProfileNode *nodePtr) {
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(dsPtr != NULL);
+  nonnull_assert(nodePtr != NULL);
+
+  Tcl_DStringTrunc(dsPtr, 0);
+  NsfProfileCallLabel(interp, dsPtr, nodePtr->cmd, nodePtr->cl);
+  if (nodePtr->frameType == NSF_CSC_TYPE_ACTIVE_FILTER) {
+    Tcl_DStringAppend(dsPtr, " [filter]", 9);
+  } else if (nodePtr->frameType == NSF_CSC_TYPE_ACTIVE_MIXIN) {
+    Tcl_DStringAppend(dsPtr, " [mixin]", 8);
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileNodeDict --
+ *
+ *    Return the children of a call graph node as a list of dicts with
+ *    the keys "method", "calls", "self", "inclusive", "max" and
+ *    "children". Nodes without calls since the last clear are omitted,
+ *    unless calls were made from them.
+ *
+ * Results:
+ *    Tcl list
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------
+ */
+static Tcl_Obj *NsfProfileNodeDict(Tcl_Interp *interp, NsfProfileNode *nodePtr, Tcl_DString *dsPtr)
+  nonnull(1) nonnull(2) nonnull(3);
+
+static Tcl_Obj *
+NsfProfileNodeDict(Tcl_Interp *interp, NsfProfileNode *nodePtr, Tcl_DString *dsPtr) {
+  Tcl_Obj *listObj = Tcl_NewListObj(0, NULL);
+  NsfProfileNode *childPtr;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(nodePtr != NULL);
+  nonnull_assert(dsPtr != NULL);
+
+  for (childPtr = nodePtr->firstChild; childPtr != NULL; childPtr = childPtr->nextSibling) {
+    Tcl_Obj *dictObj, *childrenObj = NsfProfileNodeDict(interp, childPtr, dsPtr);
+    int nrChildren = 0;
+
+    /*
+     * Nodes without calls are still active (or were cleared); they are
+     * reported only when calls were made from them.
+     */
+    INCR_REF_COUNT(childrenObj);
+    Tcl_ListObjLength(interp, childrenObj, &nrChildren);
+    if (childPtr->count == 0 && nrChildren == 0) {
+      DECR_REF_COUNT(childrenObj);
+      continue;
+    }
+    dictObj = Tcl_NewDictObj();
+    NsfProfileNodeLabel(interp, dsPtr, childPtr);
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("method", 6),
+                   Tcl_NewStringObj(Tcl_DStringValue(dsPtr), Tcl_DStringLength(dsPtr)));
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("calls", 5), Tcl_NewLongObj(childPtr->count));
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("self", 4), Tcl_NewLongObj(childPtr->selfMicroSec));
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("inclusive", 9), Tcl_NewLongObj(childPtr->inclusiveMicroSec));
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("max", 3), Tcl_NewLongObj(childPtr->maxMicroSec));
+    Tcl_DictObjPut(interp, dictObj, Tcl_NewStringObj("children", 8), childrenObj);
+    DECR_REF_COUNT(childrenObj);
+    Tcl_ListObjAppendElement(interp, listObj, dictObj);
+  }
+  return listObj;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileNodeCallgrind --
+ *
+ *    Append the data of the children of a call graph node in the
+ *    callgrind format to the provided object. Every node produces a
+ *    block with its self cost followed by the calls to its children
+ *    with their inclusive costs; callgrind tools sum up the blocks of
+ *    the same function.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Appends to resultObj.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileNodeCallgrind(Tcl_Interp *interp, NsfProfileNode *nodePtr, Tcl_Obj *resultObj,
+                                    Tcl_DString *dsPtr)
+  nonnull(1) nonnull(2) nonnull(3) nonnull(4);
+
+static void
+NsfProfileNodeCallgrind(Tcl_Interp *interp, NsfProfileNode *nodePtr, Tcl_Obj *resultObj, Tcl_DString *dsPtr) {
+  NsfProfileNode *childPtr, *grandChildPtr;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(nodePtr != NULL);
+  nonnull_assert(resultObj != NULL);
+  nonnull_assert(dsPtr != NULL);
+
+  for (childPtr = nodePtr->firstChild; childPtr != NULL; childPtr = childPtr->nextSibling) {
+    if (childPtr->count == 0) {
+      /*
+       * Still active (or cleared) node; report the calls made from it.
+       */
+      NsfProfileNodeCallgrind(interp, childPtr, resultObj, dsPtr);
+      continue;
+    }
+    NsfProfileNodeLabel(interp, dsPtr, childPtr);
+    Tcl_AppendPrintfToObj(resultObj, "fn=%s\n0 %ld\n", Tcl_DStringValue(dsPtr), childPtr->selfMicroSec);
+    for (grandChildPtr = childPtr->firstChild; grandChildPtr != NULL; grandChildPtr = grandChildPtr->nextSibling) {
+      if (grandChildPtr->count == 0) {
+        continue;
+      }
+      NsfProfileNodeLabel(interp, dsPtr, grandChildPtr);
+      Tcl_AppendPrintfToObj(resultObj, "cfn=%s\ncalls=%ld 0\n0 %ld\n", Tcl_DStringValue(dsPtr),
+                            grandChildPtr->count, grandChildPtr->inclusiveMicroSec);
+    }
+    Tcl_AppendToObj(resultObj, "\n", 1);
+    NsfProfileNodeCallgrind(interp, childPtr, resultObj, dsPtr);
+  }
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileGetCallGraph --
+ *
+ *    Return the call graph profile either as a list of nested dicts
+ *    or in the callgrind format.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Sets the interp result.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileGetCallGraph(Tcl_Interp *interp, int withCallgrind) {
+  NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
+  Tcl_DString ds, *dsPtr = &ds;
+  Tcl_Obj *resultObj;
+
+  nonnull_assert(interp != NULL);
+
+  Tcl_DStringInit(dsPtr);
+  if (withCallgrind != 0) {
+    resultObj = Tcl_NewStringObj("# callgrind format\nversion: 1\ncreator: nsf\n"
+                                 "events: Microseconds\n\n", -1);
+    if (profilePtr->callGraph != NULL) {
+      NsfProfileNodeCallgrind(interp, profilePtr->callGraph, resultObj, dsPtr);
+    }
+  } else if (profilePtr->callGraph != NULL) {
+    resultObj = NsfProfileNodeDict(interp, profilePtr->callGraph, dsPtr);
+  } else {
+    resultObj = Tcl_NewListObj(0, NULL);
+  }
+  Tcl_DStringFree(dsPtr);
+  Tcl_SetObjResult(interp, resultObj);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileRecordMethodData --
+ *
+ *    This function is invoked, when a call of a method ends. It
+ *    records profiling information based on the provided call stack
+ *    content and the caller. In particular, it records the time spent
+ *    in an object (identified with an objectKey) and the time spent
+ *    in the method (using methodKey).
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated or created profile data entries
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileRecordMethodData(Tcl_Interp *interp, NsfCallStackContent *cscPtr) {
+  NsfRuntimeState *rst = RUNTIME_STATE(interp);
+  double totalMicroSec;
+  NsfObject *obj = cscPtr->self;
+  NsfClass *cl = cscPtr->cl;
+  Tcl_DString methodKey, objectKey, methodInfo;
+  NsfProfile *profilePtr = &rst->profile;
+  struct timeval trt;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(cscPtr != NULL);
+
+  NSF_PROFILE_GETTIME(&trt);
+
+  totalMicroSec = (trt.tv_sec - cscPtr->startSec) * 1000000 + (trt.tv_usec - cscPtr->startUsec);
+  profilePtr->overallTime += totalMicroSec;
+
+  if (obj->teardown == 0 || !obj->id) {
+    return;
+  }
+
+  if (profilePtr->doCallGraph && cscPtr->cmdPtr != NULL) {
+    NsfProfileRecordCallGraph(interp, cscPtr, (long)totalMicroSec);
+  }
+
+  if (profilePtr->mode == NSF_PROFILE_MODE_POINTERS && !rst->doTrace) {
+    if (cscPtr->cmdPtr != NULL) {
+      NsfProfileFillCallTables(interp, profilePtr, cscPtr, totalMicroSec);
+    }
+    return;
+  }
+
+  Tcl_DStringInit(&objectKey);
+  NsfProfileObjectLabel(&objectKey, obj, NULL, cscPtr->methodName);
+
+  Tcl_DStringInit(&methodInfo);
+  Tcl_DStringInit(&methodKey);
+  NsfProfileMethodLabel(&methodInfo, obj, cl, cscPtr->methodName);
+
+  if (rst->doTrace) {
+    Tcl_DString traceKey;
+
+    Tcl_DStringInit(&traceKey);
+    Tcl_DStringAppendElement(&traceKey, Tcl_DStringValue(&objectKey));
+    Tcl_DStringAppend(&traceKey, " ", 1);
+    Tcl_DStringAppendElement(&traceKey, Tcl_DStringValue(&methodInfo));
+    NsfProfileTraceExitAppend(interp, Tcl_DStringValue(&traceKey), totalMicroSec);
+    Tcl_DStringFree(&traceKey);
+  }
+
+  /*
+   * Append method to object key as needed by statisitics (but not by trace)
+   */
+  Tcl_DStringAppendElement(&objectKey, cscPtr->methodName);
+
+  /*
+   * Build method key, containing actual method info and caller method info.
+   */
+  Tcl_DStringInit(&methodKey);
+  Tcl_DStringAppend(&methodKey, "{", 1);
+  Tcl_DStringAppend(&methodKey, Tcl_DStringValue(&methodInfo), Tcl_DStringLength(&methodInfo));
+  Tcl_DStringAppend(&methodKey, "}", 1);
+
+  {
+    NsfCallStackContent *cscPtrTop = NsfCallStackGetTopFrame(interp, NULL);
+    if (cscPtrTop != NULL) {
+      Tcl_DStringAppend(&methodKey, " {", 2);
+      NsfProfileMethodLabel(&methodKey, cscPtrTop->self, cscPtrTop->cl, cscPtrTop->methodName);
+      Tcl_DStringAppend(&methodKey, "}", 1);
+    } else {
+      Tcl_DStringAppend(&methodKey, " {}", 3);
+    }
+  }
+
+  NsfProfileFillTable(&profilePtr->objectData, Tcl_DStringValue(&objectKey), totalMicroSec, 0);
+  NsfProfileFillTable(&profilePtr->methodData, Tcl_DStringValue(&methodKey), totalMicroSec, 1);
+  Tcl_DStringFree(&objectKey);
+  Tcl_DStringFree(&methodKey);
+  Tcl_DStringFree(&methodInfo);
+}
+
+
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileRecordProcData --
+ *
+ *    This function is invoked, when a call of a nsf::proc. It records
+ *    time spent and count per nsf::proc.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated or created profile data entries
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileRecordProcData(Tcl_Interp *interp, const char *methodName, long startSec, long startUsec) {
+  NsfRuntimeState *rst = RUNTIME_STATE(interp);
+  NsfProfile *profilePtr = &rst->profile;
+  double totalMicroSec;
+  struct timeval trt;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(methodName != NULL);
+
+  NSF_PROFILE_GETTIME(&trt);
+
+  totalMicroSec = (trt.tv_sec - startSec) * 1000000 + (trt.tv_usec - startUsec);
+  profilePtr->overallTime += totalMicroSec;
+
+  if (rst->doTrace) {
+    NsfProfileTraceExitAppend(interp, methodName, totalMicroSec);
+  }
+
+  NsfProfileFillTable(&profilePtr->procData, methodName, totalMicroSec, 0);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileClearTable --
+ *
+ *    Clear all data in a profile table.
  *
  * Results:
  *    None
@@ -663,7 +2191,7 @@ NsfProfileClearTable(Tcl_HashTable *table) {
   for (hPtr = Tcl_FirstHashEntry(table, &hSrch); hPtr;
        hPtr = Tcl_NextHashEntry(&hSrch)) {
     NsfProfileData *value = (NsfProfileData *) Tcl_GetHashValue(hPtr);
-    ckfree((char *) value);
+    NsfProfileDataFree(value);
     Tcl_DeleteHashEntry(hPtr);
   }
 }
@@ -694,8 +2222,15 @@ NsfProfileClearData(Tcl_Interp *interp) {
   NsfProfileClearTable(&profilePtr->objectData);
   NsfProfileClearTable(&profilePtr->methodData);
   NsfProfileClearTable(&profilePtr->procData);
+  NsfProfileClearCallTable(&profilePtr->callData);
+  NsfProfileClearObjectCallTable(&profilePtr->objectCallData);
+  memset(profilePtr->callCache, 0, sizeof(NsfProfileCallCacheEntry) * NSF_PROFILE_CALLCACHE_SIZE);
+  NsfProfileClearTable(&profilePtr->sampleData);
+  if (profilePtr->callGraph != NULL) {
+    NsfProfileNodeReset(profilePtr->callGraph);
+  }
 
-  gettimeofday(&trt, NULL);
+  NSF_PROFILE_GETTIME(&trt);
   profilePtr->startSec = trt.tv_sec;
   profilePtr->startUSec = trt.tv_usec;
   profilePtr->overallTime = 0;
@@ -739,6 +2274,7 @@ NsfProfileGetTable(Tcl_Interp *interp, Tcl_HashTable *table) {
     Tcl_ListObjAppendElement(interp, subList, Tcl_NewStringObj(key, -1));
     Tcl_ListObjAppendElement(interp, subList, Tcl_NewIntObj(value->microSec));
     Tcl_ListObjAppendElement(interp, subList, Tcl_NewIntObj(value->count));
+    Tcl_ListObjAppendElement(interp, subList, NsfProfilePercentiles(interp, value));
     Tcl_ListObjAppendElement(interp, list, subList);
   }
   return list;
@@ -751,19 +2287,26 @@ NsfProfileGetTable(Tcl_Interp *interp, Tcl_HashTable *table) {
  *    Return recorded profiling information. This function returns a
  *    list containing (a) the elapsed time since the last clear (or
  *    init), (b) the cumulative time, (c) the list with the per-object
- *    data and (d) the list with the method invocation data.
+ *    data, (d) the list with the method invocation data, (e) the list
+ *    with the nsf::proc data and (f) the trace. Every entry of the
+ *    data lists contains the key, the cumulative time, the number of
+ *    calls and, as fourth element, a dict with the latency
+ *    percentiles p50, p90, p99, p99.9 and the maximum latency in
+ *    microseconds. Since histograms are kept for the method data only,
+ *    this dict is empty for the entries of the other lists. When
+ *    withReset is set, the data is flushed after reading.
  *
  * Results:
  *    Tcl List
  *
  * Side effects:
- *    None.
+ *    Potentially flushes the profile data.
  *
  *----------------------------------------------------------------------
  */
 
 void
-NsfProfileGetData(Tcl_Interp *interp) {
+NsfProfileGetData(Tcl_Interp *interp, int withReset) {
   Tcl_Obj *list = Tcl_NewListObj(0, NULL);
   NsfProfile *profilePtr = &RUNTIME_STATE(interp)->profile;
   long totalMicroSec;
@@ -771,17 +2314,50 @@ NsfProfileGetData(Tcl_Interp *interp) {
 
   nonnull_assert(interp != NULL);
 
-  gettimeofday(&trt, NULL);
+  NSF_PROFILE_GETTIME(&trt);
   totalMicroSec = (trt.tv_sec - profilePtr->startSec) * 1000000 + (trt.tv_usec - profilePtr->startUSec);
 
   Tcl_ListObjAppendElement(interp, list, Tcl_NewIntObj(totalMicroSec));
   Tcl_ListObjAppendElement(interp, list, Tcl_NewIntObj(profilePtr->overallTime));
-  Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &profilePtr->objectData));
-  Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &profilePtr->methodData));
+  if (profilePtr->objectCallData.numEntries > 0) {
+    Tcl_HashTable objectTable;
+
+    /*
+     * Merge the pointer keyed data into the object data; the labels are
+     * built here and not during the calls.
+     */
+    Tcl_InitHashTable(&objectTable, TCL_STRING_KEYS);
+    NsfProfileMergeTable(&objectTable, &profilePtr->objectData);
+    NsfProfileObjectCallTableToObjectData(interp, &profilePtr->objectCallData, &objectTable);
+    Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &objectTable));
+    NsfProfileClearTable(&objectTable);
+    Tcl_DeleteHashTable(&objectTable);
+  } else {
+    Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &profilePtr->objectData));
+  }
+  if (profilePtr->callData.numEntries > 0) {
+    Tcl_HashTable methodTable;
+
+    /*
+     * Same for the method data.
+     */
+    Tcl_InitHashTable(&methodTable, TCL_STRING_KEYS);
+    NsfProfileMergeTable(&methodTable, &profilePtr->methodData);
+    NsfProfileCallTableToMethodData(interp, &profilePtr->callData, &methodTable);
+    Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &methodTable));
+    NsfProfileClearTable(&methodTable);
+    Tcl_DeleteHashTable(&methodTable);
+  } else {
+    Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &profilePtr->methodData));
+  }
   Tcl_ListObjAppendElement(interp, list, NsfProfileGetTable(interp, &profilePtr->procData));
   Tcl_ListObjAppendElement(interp, list, Tcl_NewStringObj(profilePtr->traceDs.string, profilePtr->traceDs.length));
 
   Tcl_SetObjResult(interp, list);
+
+  if (withReset != 0) {
+    NsfProfileClearData(interp);
+  }
 }
 
 /*
@@ -810,8 +2386,18 @@ NsfProfileInit(Tcl_Interp *interp) {
   Tcl_InitHashTable(&profilePtr->objectData, TCL_STRING_KEYS);
   Tcl_InitHashTable(&profilePtr->methodData, TCL_STRING_KEYS);
   Tcl_InitHashTable(&profilePtr->procData, TCL_STRING_KEYS);
-
-  gettimeofday(&trt, NULL);
+  Tcl_InitHashTable(&profilePtr->callData, NSF_PROFILE_CALLKEY_INTS);
+  Tcl_InitHashTable(&profilePtr->objectCallData, TCL_ONE_WORD_KEYS);
+  profilePtr->callCache = (NsfProfileCallCacheEntry *)
+    ckalloc(sizeof(NsfProfileCallCacheEntry) * NSF_PROFILE_CALLCACHE_SIZE);
+  memset(profilePtr->callCache, 0, sizeof(NsfProfileCallCacheEntry) * NSF_PROFILE_CALLCACHE_SIZE);
+  Tcl_InitHashTable(&profilePtr->sampleData, TCL_STRING_KEYS);
+  profilePtr->sampler = NULL;
+  profilePtr->callGraph = NULL;
+  profilePtr->doCallGraph = 0;
+  profilePtr->mode = NSF_PROFILE_MODE_LABELS;
+
+  NSF_PROFILE_GETTIME(&trt);
   profilePtr->startSec = trt.tv_sec;
   profilePtr->startUSec = trt.tv_usec;
   profilePtr->overallTime = 0;
@@ -840,14 +2426,368 @@ NsfProfileFree(Tcl_Interp *interp) {
 
   nonnull_assert(interp != NULL);
 
+  NsfProfileSample(interp, 0, 0);
+  NsfProfileAlloc(interp, 0);
   NsfProfileClearData(interp);
   Tcl_DeleteHashTable(&profilePtr->objectData);
   Tcl_DeleteHashTable(&profilePtr->methodData);
   Tcl_DeleteHashTable(&profilePtr->procData);
+  Tcl_DeleteHashTable(&profilePtr->callData);
+  Tcl_DeleteHashTable(&profilePtr->objectCallData);
+  ckfree((char *)profilePtr->callCache);
+  Tcl_DeleteHashTable(&profilePtr->sampleData);
+  if (profilePtr->callGraph != NULL) {
+    NsfProfileNodeFree(profilePtr->callGraph);
+    profilePtr->callGraph = NULL;
+  }
   Tcl_DStringFree(&profilePtr->traceDs);
 }
 #endif
 
+/*
+ * Allocation tracking: allocations of the main NSF structures are
+ * recorded per thread in a table keyed by the address of the allocated
+ * memory. Every record refers to the statistics of the allocating
+ * method (site) and of its class, which are updated when the memory is
+ * freed. Allocation tracking does not depend on NSF_PROFILE, since
+ * the hooks cost only a test of a global counter: allocations are
+ * checked while some thread has tracking enabled, frees while tracked
+ * allocations are alive, such that memory allocated during tracking
+ * is accounted for also after tracking was turned off.
+ */
+int NsfProfileAllocTracking = 0;
+int NsfProfileAllocLive = 0;
+static NsfMutex allocMutex = 0;
+
+typedef struct NsfProfileAllocStats {
+  long liveCount;
+  long liveBytes;
+  long count;
+  long bytes;
+} NsfProfileAllocStats;
+
+typedef struct NsfProfileAllocRecord {
+  size_t size;
+  NsfProfileAllocStats *siteStats;
+  NsfProfileAllocStats *classStats;
+} NsfProfileAllocRecord;
+
+typedef struct NsfProfileAllocData {
+  int initialized;
+  int enabled;
+  Tcl_Interp *interp;
+  Tcl_HashTable records;
+  Tcl_HashTable sites;
+  Tcl_HashTable classes;
+} NsfProfileAllocData;
+
+static Tcl_ThreadDataKey allocDataKey;
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileAllocStatsGet --
+ *
+ *    Return the statistics for the provided key of a table, create
+ *    it if necessary.
+ *
+ * Results:
+ *    Allocation statistics
+ *
+ * Side effects:
+ *    Potentially created hash entry.
+ *
+ *----------------------------------------------------------------------
+ */
+static NsfProfileAllocStats *NsfProfileAllocStatsGet(Tcl_HashTable *table, const char *key)
+  nonnull(1) nonnull(2) returns_nonnull;
+
+static NsfProfileAllocStats *
+NsfProfileAllocStatsGet(Tcl_HashTable *table, const char *key) {
+  NsfProfileAllocStats *statsPtr;
+  Tcl_HashEntry *hPtr;
+  int isNew;
+
+  nonnull_assert(table != NULL);
+  nonnull_assert(key != NULL);
+
+  hPtr = Tcl_CreateHashEntry(table, key, &isNew);
+  if (isNew != 0) {
+    statsPtr = (NsfProfileAllocStats *)ckalloc(sizeof(NsfProfileAllocStats));
+    memset(statsPtr, 0, sizeof(NsfProfileAllocStats));
+    Tcl_SetHashValue(hPtr, statsPtr);
+  } else {
+    statsPtr = (NsfProfileAllocStats *)Tcl_GetHashValue(hPtr);
+  }
+  return statsPtr;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileAllocDataFree --
+ *
+ *    Thread exit handler, freeing the allocation tracking data.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Frees memory.
+ *
+ *----------------------------------------------------------------------
+ */
+static void NsfProfileAllocDataFree(ClientData clientData) nonnull(1);
+
+static void
+NsfProfileAllocDataFree(ClientData clientData) {
+  NsfProfileAllocData *dataPtr = (NsfProfileAllocData *)clientData;
+  Tcl_HashTable *tables[3];
+  int i;
+
+  nonnull_assert(clientData != NULL);
+
+  NsfMutexLock(&allocMutex);
+  NsfProfileAllocLive -= dataPtr->records.numEntries;
+  if (dataPtr->enabled != 0) {
+    NsfProfileAllocTracking --;
+  }
+  NsfMutexUnlock(&allocMutex);
+
+  tables[0] = &dataPtr->records;
+  tables[1] = &dataPtr->sites;
+  tables[2] = &dataPtr->classes;
+  for (i = 0; i < 3; i++) {
+    Tcl_HashSearch hSrch;
+    Tcl_HashEntry *hPtr;
+
+    for (hPtr = Tcl_FirstHashEntry(tables[i], &hSrch); hPtr;
+         hPtr = Tcl_NextHashEntry(&hSrch)) {
+      ckfree((char *)Tcl_GetHashValue(hPtr));
+    }
+    Tcl_DeleteHashTable(tables[i]);
+  }
+  dataPtr->initialized = 0;
+  dataPtr->enabled = 0;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileAllocTrack, NsfProfileAllocUntrack --
+ *
+ *    Record an allocation of the given kind and size, attributed to
+ *    the currently executing method of the interp which turned
+ *    tracking on, and remove the record when the memory is freed.
+ *    These functions are called via NSF_PROFILE_ALLOC() and
+ *    NSF_PROFILE_FREE().
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Updated allocation statistics.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileAllocTrack(const char *kind, void *p, size_t size) {
+  NsfProfileAllocData *dataPtr = (NsfProfileAllocData *)Tcl_GetThreadData(&allocDataKey, sizeof(NsfProfileAllocData));
+  NsfProfileAllocRecord *recordPtr;
+  NsfCallStackContent *cscPtr;
+  Tcl_HashEntry *hPtr;
+  Tcl_DString ds, siteDs;
+  int isNew;
+
+  nonnull_assert(kind != NULL);
+  nonnull_assert(p != NULL);
+
+  if (dataPtr->enabled == 0) {
+    return;
+  }
+
+  Tcl_DStringInit(&ds);
+  cscPtr = NsfCallStackGetTopFrame(dataPtr->interp, NULL);
+  if (cscPtr != NULL && cscPtr->self != NULL) {
+    Tcl_DStringAppend(&ds, cscPtr->cl != NULL ? ClassName(cscPtr->cl) : ObjectName(cscPtr->self), -1);
+  } else {
+    Tcl_DStringAppend(&ds, "<toplevel>", -1);
+  }
+
+  hPtr = Tcl_CreateHashEntry(&dataPtr->records, (char *)p, &isNew);
+  if (isNew != 0) {
+    recordPtr = (NsfProfileAllocRecord *)ckalloc(sizeof(NsfProfileAllocRecord));
+    Tcl_SetHashValue(hPtr, recordPtr);
+    NsfMutexLock(&allocMutex);
+    NsfProfileAllocLive ++;
+    NsfMutexUnlock(&allocMutex);
+  } else {
+    /*
+     * The memory was freed without being untracked; forget the old
+     * record.
+     */
+    recordPtr = (NsfProfileAllocRecord *)Tcl_GetHashValue(hPtr);
+    recordPtr->siteStats->liveCount --;
+    recordPtr->siteStats->liveBytes -= (long)recordPtr->size;
+    recordPtr->classStats->liveCount --;
+    recordPtr->classStats->liveBytes -= (long)recordPtr->size;
+  }
+  recordPtr->size = size;
+  recordPtr->classStats = NsfProfileAllocStatsGet(&dataPtr->classes, Tcl_DStringValue(&ds));
+
+  if (cscPtr != NULL && cscPtr->self != NULL && cscPtr->cmdPtr != NULL) {
+    Tcl_DStringAppend(&ds, " ", 1);
+    Tcl_DStringAppend(&ds, Tcl_GetCommandName(dataPtr->interp, cscPtr->cmdPtr), -1);
+  }
+  Tcl_DStringInit(&siteDs);
+  Tcl_DStringAppendElement(&siteDs, Tcl_DStringValue(&ds));
+  Tcl_DStringAppendElement(&siteDs, kind);
+  recordPtr->siteStats = NsfProfileAllocStatsGet(&dataPtr->sites, Tcl_DStringValue(&siteDs));
+  Tcl_DStringFree(&siteDs);
+  Tcl_DStringFree(&ds);
+
+  recordPtr->siteStats->liveCount ++;
+  recordPtr->siteStats->liveBytes += (long)size;
+  recordPtr->siteStats->count ++;
+  recordPtr->siteStats->bytes += (long)size;
+  recordPtr->classStats->liveCount ++;
+  recordPtr->classStats->liveBytes += (long)size;
+  recordPtr->classStats->count ++;
+  recordPtr->classStats->bytes += (long)size;
+}
+
+void
+NsfProfileAllocUntrack(void *p) {
+  NsfProfileAllocData *dataPtr = (NsfProfileAllocData *)Tcl_GetThreadData(&allocDataKey, sizeof(NsfProfileAllocData));
+  NsfProfileAllocRecord *recordPtr;
+  Tcl_HashEntry *hPtr;
+
+  nonnull_assert(p != NULL);
+
+  if (dataPtr->initialized == 0) {
+    return;
+  }
+  hPtr = Tcl_FindHashEntry(&dataPtr->records, (char *)p);
+  if (hPtr == NULL) {
+    return;
+  }
+  recordPtr = (NsfProfileAllocRecord *)Tcl_GetHashValue(hPtr);
+  recordPtr->siteStats->liveCount --;
+  recordPtr->siteStats->liveBytes -= (long)recordPtr->size;
+  recordPtr->classStats->liveCount --;
+  recordPtr->classStats->liveBytes -= (long)recordPtr->size;
+  ckfree((char *)recordPtr);
+  Tcl_DeleteHashEntry(hPtr);
+  NsfMutexLock(&allocMutex);
+  NsfProfileAllocLive --;
+  NsfMutexUnlock(&allocMutex);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileAlloc --
+ *
+ *    Turn allocation tracking for the current thread on or off.
+ *    Allocations are attributed to the methods executing in the
+ *    provided interp.
+ *
+ * Results:
+ *    Previous state
+ *
+ * Side effects:
+ *    Potentially initializes the allocation tracking data.
+ *
+ *----------------------------------------------------------------------
+ */
+int
+NsfProfileAlloc(Tcl_Interp *interp, int withEnable) {
+  NsfProfileAllocData *dataPtr = (NsfProfileAllocData *)Tcl_GetThreadData(&allocDataKey, sizeof(NsfProfileAllocData));
+  int oldState = dataPtr->enabled;
+
+  nonnull_assert(interp != NULL);
+
+  if (withEnable != 0 && dataPtr->initialized == 0) {
+    Tcl_InitHashTable(&dataPtr->records, TCL_ONE_WORD_KEYS);
+    Tcl_InitHashTable(&dataPtr->sites, TCL_STRING_KEYS);
+    Tcl_InitHashTable(&dataPtr->classes, TCL_STRING_KEYS);
+    Tcl_CreateThreadExitHandler(NsfProfileAllocDataFree, dataPtr);
+    dataPtr->initialized = 1;
+  }
+  if (withEnable != 0) {
+    dataPtr->interp = interp;
+    dataPtr->enabled = 1;
+  } else if (dataPtr->interp == interp) {
+    dataPtr->enabled = 0;
+    dataPtr->interp = NULL;
+  }
+  if (dataPtr->enabled != oldState) {
+    NsfMutexLock(&allocMutex);
+    NsfProfileAllocTracking += (dataPtr->enabled != 0) ? 1 : -1;
+    NsfMutexUnlock(&allocMutex);
+  }
+  return oldState;
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfProfileGetAlloc --
+ *
+ *    Return the allocation statistics of the current thread as a
+ *    list of two lists: the statistics per allocating method and
+ *    kind of allocation ({class method} kind liveCount liveBytes count
+ *    bytes), and the statistics per class of the allocating methods
+ *    (class liveCount liveBytes count bytes). Entries without live
+ *    allocations are included, since they show the allocation rate.
+ *
+ * Results:
+ *    None
+ *
+ * Side effects:
+ *    Sets the interp result.
+ *
+ *----------------------------------------------------------------------
+ */
+void
+NsfProfileGetAlloc(Tcl_Interp *interp) {
+  NsfProfileAllocData *dataPtr = (NsfProfileAllocData *)Tcl_GetThreadData(&allocDataKey, sizeof(NsfProfileAllocData));
+  Tcl_Obj *resultObj = Tcl_NewListObj(0, NULL);
+  Tcl_HashTable *tables[2];
+  int i;
+
+  nonnull_assert(interp != NULL);
+
+  tables[0] = &dataPtr->sites;
+  tables[1] = &dataPtr->classes;
+  for (i = 0; i < 2; i++) {
+    Tcl_Obj *listObj = Tcl_NewListObj(0, NULL);
+
+    if (dataPtr->initialized != 0) {
+      Tcl_HashSearch hSrch;
+      Tcl_HashEntry *hPtr;
+
+      for (hPtr = Tcl_FirstHashEntry(tables[i], &hSrch); hPtr;
+           hPtr = Tcl_NextHashEntry(&hSrch)) {
+        NsfProfileAllocStats *statsPtr = (NsfProfileAllocStats *)Tcl_GetHashValue(hPtr);
+        Tcl_Obj *keyObj = Tcl_NewStringObj(Tcl_GetHashKey(tables[i], hPtr), -1);
+        Tcl_Obj *entryObj;
+
+        if (i == 0) {
+          /*
+           * The site keys are lists of the form {{class method} kind}.
+           */
+          entryObj = keyObj;
+        } else {
+          entryObj = Tcl_NewListObj(1, &keyObj);
+        }
+        Tcl_ListObjAppendElement(interp, entryObj, Tcl_NewLongObj(statsPtr->liveCount));
+        Tcl_ListObjAppendElement(interp, entryObj, Tcl_NewLongObj(statsPtr->liveBytes));
+        Tcl_ListObjAppendElement(interp, entryObj, Tcl_NewLongObj(statsPtr->count));
+        Tcl_ListObjAppendElement(interp, entryObj, Tcl_NewLongObj(statsPtr->bytes));
+        Tcl_ListObjAppendElement(interp, listObj, entryObj);
+      }
+    }
+    Tcl_ListObjAppendElement(interp, resultObj, listObj);
+  }
+  Tcl_SetObjResult(interp, resultObj);
+}
+
 /*
  * Local Variables:
  * mode: c
@@ -270,6 +270,21 @@ Nsf_RenameObjCmd(ClientData clientData, Tcl_Interp *interp, int objc, Tcl_Obj *C
     if (parentCmd != NULL) {
       NsfObjectMethodEpochIncr("::rename");
     }
+    NsfClassMethodEpochIncrCmd(interp, cmd);
+
+    if (object != NULL && object->id == cmd && *(ObjStr(objv[2])) != '\0') {
+      int result;
+
+      /*
+       * An object without a move method is renamed by Tcl; keep the
+       * number of children of the old and new parent up to date. An
+       * imported object command is not a child of its namespace.
+       */
+      NsfObjectChildCountUpdate(cmd, -1);
+      result = NsfCallCommand(interp, NSF_RENAME, objc, objv);
+      NsfObjectChildCountUpdate(cmd, 1);
+      return result;
+    }
   }
 
   /* Actually rename the cmd using Tcl's rename*/
@@ -511,13 +511,116 @@ CallStackGetTopFrame0(Tcl_Interp *interp) {
   return NULL;
 }
 
-#if defined(NSF_PROFILE)
 NsfCallStackContent* NsfCallStackGetTopFrame(Tcl_Interp *interp, Tcl_CallFrame **framePtrPtr) nonnull(1);
 
 NsfCallStackContent*
 NsfCallStackGetTopFrame(Tcl_Interp *interp, Tcl_CallFrame **framePtrPtr) {
   return CallStackGetTopFrame(interp, framePtrPtr);
 }
+
+#if defined(NSF_PROFILE)
+
+/*
+ *----------------------------------------------------------------------
+ * NsfCallStackNextMethodFrame --
+ *
+ *    Return the next frame of a (scripted or nonleaf) method on the
+ *    execution stack, starting with the specified frame.
+ *
+ * Results:
+ *    Tcl_CallFrame or NULL.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------
+ */
+Tcl_CallFrame *
+NsfCallStackNextMethodFrame(Tcl_CallFrame *framePtr) {
+
+  if (framePtr == NULL) {
+    return NULL;
+  }
+  return CallStackNextFrameOfType(framePtr, FRAME_IS_NSF_METHOD|FRAME_IS_NSF_CMETHOD);
+}
+
+/*
+ *----------------------------------------------------------------------
+ * NsfCallStackFolded --
+ *
+ *    Append the currently active NSF method frames of the interp to
+ *    the provided DString in the "folded" format, i.e. the frames
+ *    from the outermost to the innermost invocation separated by
+ *    semicolons. Every frame is labeled by the class (or object) and
+ *    the method name; mixin and filter invocations are marked as
+ *    such. Only frames on the execution stack are considered, uplevel
+ *    does not affect the result.
+ *
+ * Results:
+ *    Number of frames appended.
+ *
+ * Side effects:
+ *    Appends to the DString.
+ *
+ *----------------------------------------------------------------------
+ */
+#define NSF_FOLDED_STATIC_FRAMES 64
+
+int NsfCallStackFolded(Tcl_Interp *interp, Tcl_DString *dsPtr) nonnull(1) nonnull(2);
+
+int
+NsfCallStackFolded(Tcl_Interp *interp, Tcl_DString *dsPtr) {
+  NsfCallStackContent *staticFrames[NSF_FOLDED_STATIC_FRAMES], **frames = staticFrames;
+  Tcl_CallFrame *framePtr;
+  int nrFrames = 0, i;
+
+  nonnull_assert(interp != NULL);
+  nonnull_assert(dsPtr != NULL);
+
+  for (framePtr = (Tcl_CallFrame *)Tcl_Interp_framePtr(interp);
+       framePtr != NULL && (framePtr = CallStackNextFrameOfType(framePtr, FRAME_IS_NSF_METHOD|FRAME_IS_NSF_CMETHOD));
+       framePtr = Tcl_CallFrame_callerPtr(framePtr)) {
+    nrFrames++;
+  }
+  if (nrFrames > NSF_FOLDED_STATIC_FRAMES) {
+    frames = (NsfCallStackContent **)ckalloc(sizeof(NsfCallStackContent *) * (unsigned)nrFrames);
+  }
+
+  i = nrFrames;
+  for (framePtr = (Tcl_CallFrame *)Tcl_Interp_framePtr(interp);
+       framePtr != NULL && (framePtr = CallStackNextFrameOfType(framePtr, FRAME_IS_NSF_METHOD|FRAME_IS_NSF_CMETHOD));
+       framePtr = Tcl_CallFrame_callerPtr(framePtr)) {
+    frames[--i] = (NsfCallStackContent *)Tcl_CallFrame_clientData(framePtr);
+  }
+
+  for (i = 0; i < nrFrames; i++) {
+    NsfCallStackContent *cscPtr = frames[i];
+    unsigned int frameType = cscPtr->frameType & ~NSF_CSC_TYPE_INACTIVE;
+
+    if (i > 0) {
+      Tcl_DStringAppend(dsPtr, ";", 1);
+    }
+    if (cscPtr->cl != NULL) {
+      Tcl_DStringAppend(dsPtr, ClassName(cscPtr->cl), -1);
+    } else if (cscPtr->self != NULL) {
+      Tcl_DStringAppend(dsPtr, ObjectName(cscPtr->self), -1);
+    }
+    Tcl_DStringAppend(dsPtr, " ", 1);
+    Tcl_DStringAppend(dsPtr, cscPtr->cmdPtr != NULL
+                      ? Tcl_GetCommandName(interp, cscPtr->cmdPtr)
+                      : "?", -1);
+    if (frameType == NSF_CSC_TYPE_ACTIVE_FILTER) {
+      Tcl_DStringAppend(dsPtr, " [filter]", 9);
+    } else if (frameType == NSF_CSC_TYPE_ACTIVE_MIXIN) {
+      Tcl_DStringAppend(dsPtr, " [mixin]", 8);
+    }
+  }
+
+  if (frames != staticFrames) {
+    ckfree((char *)frames);
+  }
+  return nrFrames;
+}
 #endif
 
 /*
@@ -1133,10 +1236,12 @@ CscInit_(/*@notnull@*/ NsfCallStackContent *cscPtr, NsfObject *object, NsfClass
   nonnull_assert(object != NULL);
 
 #if defined(NSF_PROFILE)
-  gettimeofday(&trt, NULL);
+  NSF_PROFILE_GETTIME(&trt);
 
   cscPtr->startUsec = trt.tv_usec;
   cscPtr->startSec = trt.tv_sec;
+  cscPtr->childMicroSec = 0;
+  cscPtr->profileNode = NULL;
 #endif
 
   /*
@@ -24,6 +24,7 @@ set ::nxdoc::include(::nsf::object::unknown::add) 0
 set ::nxdoc::include(::nsf::object::unknown::get) 0
 set ::nxdoc::include(::nsf::object::unknown::delete) 0
 set ::nxdoc::include(::nsf::object::unknown::keys) 0
+set ::nxdoc::include(::nsf::object::unknown::update-patterns) 0
 set ::nxdoc::include(::nsf::exithandler) 1
 set ::nxdoc::include(::nsf::__exithandler) 0
 set ::nxdoc::include(::nsf::log) 1
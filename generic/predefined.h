@@ -34,15 +34,26 @@ static char cmd[] =
 "::nsf::method::provide volatile {::nsf::method::alias volatile   ::nsf::methods::object::volatile}\n"
 "proc ::nsf::object::unknown {name} {\n"
 "foreach {key handler} [array get ::nsf::object::unknown] {\n"
+"if {[info exists ::nsf::object::unknown::pattern($key)]\n"
+"&& ![string match $::nsf::object::unknown::pattern($key) $name]} {\n"
+"continue}\n"
 "set result [uplevel [list {*}$handler $name]]\n"
 "if {$result ne \"\"} {\n"
 "return $result}}\n"
 "return \"\"}\n"
 "namespace eval ::nsf::object::unknown {\n"
-"proc add {key handler} {set ::nsf::object::unknown($key) $handler}\n"
+"proc add {key handler {pattern *}} {\n"
+"set ::nsf::object::unknown::pattern($key) $pattern\n"
+"set ::nsf::object::unknown($key) $handler\n"
+"update-patterns}\n"
 "proc get {key}         {return $::nsf::object::unknown($key)}\n"
-"proc delete {key}      {array unset ::nsf::object::unknown($key)}\n"
-"proc keys {}           {array names ::nsf::object::unknown}}\n"
+"proc delete {key}      {\n"
+"unset -nocomplain ::nsf::object::unknown::pattern($key) ::nsf::object::unknown($key)\n"
+"update-patterns}\n"
+"proc keys {}           {array names ::nsf::object::unknown}\n"
+"proc update-patterns {} {\n"
+"set ::nsf::object::unknown::patterns \\\n"
+"[lsort -unique [dict values [array get ::nsf::object::unknown::pattern]]]}}\n"
 "namespace eval ::nsf::argument {}\n"
 "proc ::nsf::argument::unknown {args} {\n"
 "return \"\"}\n"
@@ -0,0 +1,758 @@
+#
+# Compiler from a subset of Tcl into the Tcl assembly language of the
+# nsf asm engine (see generic/asm/README).
+#
+# The compiler is used by "nsf::method::create ... -compile asm ...".
+# It accepts method bodies consisting of
+#
+#   - set, incr, if, for, while, break, continue and return,
+#   - self dispatches (": foo ..." or ":foo ...") and dispatches on
+#     objects passed as arguments ("$obj foo ..."),
+#   - comparisons (<, <=, >, >=) as conditions,
+#
+# operating on local variables, instance variables (${:x}, "set :x
+# ...") and method arguments. Comparisons and increments have the
+# semantics of expr and incr. For all other bodies, the compiler
+# raises an error starting with "unsupported", and the method is
+# defined as a Tcl method.
+#
+# Arguments of type "int" (parameters with the type "int32"; the
+# type "integer" accepts bignums) and local variables receiving only
+# such arguments and integer constants (in the range of a C int) are
+# kept unboxed in integer slots, operated on by the *Int instructions
+# of the engine; the values are boxed when they are used as objects
+# (e.g. as result or as value of an instance variable). Integer slots
+# are only incremented by constants; a variable incremented by
+# anything else is kept in an object slot. All other values are
+# operated on by the object instructions, which handle integers
+# fitting into a long without calling Tcl.
+#
+package provide nsf::asm 1.0
+
+#
+# The compiler lives in its own namespace, since ::nsf::asm::proc would
+# shadow Tcl's proc command in ::nsf::asm.
+#
+namespace eval ::nsf::asm::compiler {
+
+  variable state
+
+  #
+  # Return the asm code for the body of a method or raise an error
+  # when the body can't be compiled. The optional "types" specify the
+  # slot type ("int" or "obj") for every argument.
+  #
+  # Local variables are assumed to hold integers; when a variable
+  # receives another value, it is demoted to an object variable and
+  # the body is compiled again.
+  #
+  proc compile {methodName arguments body {types ""}} {
+    if {$types eq ""} {
+      set types [lrepeat [llength $arguments] obj]
+    } elseif {[llength $types] != [llength $arguments]} {
+      return -code error "types '$types' do not match arguments '$arguments'"
+    }
+    set demoted {}
+    while {1} {
+      try {
+        return [Compile $methodName $arguments $body $types $demoted]
+      } trap {NSF ASM DEMOTE} {- options} {
+        lappend demoted [lindex [dict get $options -errorcode] end]
+      }
+    }
+  }
+
+  proc Compile {methodName arguments body types demoted} {
+    variable state
+    array unset state
+    array set state [list method $methodName consts {} vars {} args {} \
+                         types {} demoted $demoted intSlots {} intValues {} \
+                         argRefs {} assigned {} defined {} loops {} \
+                         code {} nrLabels 0 nrTemps 0]
+
+    if {[string first \\ $body] > -1} {
+      Unsupported "backslash"
+    }
+    set i 0
+    foreach a $arguments {
+      if {[llength $a] != 1 || ![regexp {^[a-zA-Z_][a-zA-Z0-9_]*$} $a] || $a eq "args"} {
+        Unsupported "argument '$a'"
+      }
+      dict set state(args) $a $i
+      dict set state(types) $a [lindex $types $i]
+      lappend state(defined) $a
+      incr i
+    }
+
+    Block $body 1
+    return [Assemble]
+  }
+
+  proc Unsupported {what} {
+    return -code error "unsupported $what"
+  }
+
+  ######################################################################
+  # Parsing
+  ######################################################################
+
+  #
+  # Split a script into its commands, skipping comments.
+  #
+  proc Commands {script} {
+    set commands {}
+    set current ""
+    set n [string length $script]
+    for {set i 0} {$i < $n} {incr i} {
+      set c [string index $script $i]
+      if {$c eq "#" && [string trim $current] eq ""} {
+        set i [string first \n $script $i]
+        if {$i < 0} break
+        set current ""
+      } elseif {($c eq "\n" || $c eq ";") && [info complete $current]} {
+        if {[string trim $current] ne ""} {lappend commands [string trim $current]}
+        set current ""
+      } else {
+        append current $c
+      }
+    }
+    if {[string trim $current] ne ""} {
+      if {![info complete $current]} {Unsupported "incomplete command"}
+      lappend commands [string trim $current]
+    }
+    return $commands
+  }
+
+  #
+  # Split a command into its words. Every word is returned as a pair
+  # of the kind (braced, quoted, bare) and its text.
+  #
+  proc Words {command} {
+    set words {}
+    set n [string length $command]
+    set i 0
+    while {$i < $n} {
+      if {[string is space [string index $command $i]]} {incr i; continue}
+      set c [string index $command $i]
+      set kind [expr {$c eq "\{" ? "braced" : $c eq "\"" ? "quoted" : "bare"}]
+      for {set j $i} {$j < $n} {incr j} {
+        set d [string index $command $j]
+        if {$kind eq "bare"} {
+          if {[string is space $d] && [info complete [string range $command $i $j-1]]} break
+        } elseif {$j > $i && $d eq [expr {$kind eq "braced" ? "\}" : "\""}]
+                  && [info complete [string range $command $i $j]]} {
+          incr j
+          break
+        }
+      }
+      set text [string range $command $i $j-1]
+      if {$kind ne "bare"} {
+        if {$j < $n && ![string is space [string index $command $j]]} {
+          Unsupported "word '$text'"
+        }
+        set text [string range $text 1 end-1]
+        if {$kind eq "quoted" && [regexp {[$\[]} $text]} {
+          Unsupported "substitution in '$text'"
+        }
+      }
+      lappend words [list $kind $text]
+      set i $j
+    }
+    return $words
+  }
+
+  #
+  # Classify a word as a value source: a constant, a (local or argument)
+  # variable, an instance variable or a self dispatch.
+  #
+  proc Source {word} {
+    variable state
+    lassign $word kind text
+    if {$kind ne "bare"} {
+      return [list const $text]
+    }
+    if {[regexp {^\$\{?(:?[a-zA-Z_][a-zA-Z0-9_]*)\}?$} $text _ name]
+        && ([string index $text 1] eq "\{") == ([string index $text end] eq "\}")} {
+      if {[string index $name 0] eq ":"} {
+        return [list ivar [string range $name 1 end]]
+      }
+      if {$name ni $state(defined)} {
+        Unsupported "read of variable '$name' before it is set"
+      }
+      return [list var $name]
+    }
+    if {[string index $text 0] eq "\[" && [string index $text end] eq "\]"} {
+      set commands [Commands [string range $text 1 end-1]]
+      if {[llength $commands] != 1} {Unsupported "command substitution '$text'"}
+      return [list call [lindex $commands 0]]
+    }
+    if {[regexp {[$\[]} $text]} {
+      Unsupported "substitution in '$text'"
+    }
+    return [list const $text]
+  }
+
+  ######################################################################
+  # Symbols and code emission
+  ######################################################################
+
+  proc Const {value} {
+    variable state
+    if {![dict exists $state(consts) $value]} {
+      dict set state(consts) $value [dict size $state(consts)]
+    }
+    return c[dict get $state(consts) $value]
+  }
+
+  proc Var {name} {
+    variable state
+    if {![dict exists $state(vars) $name]} {
+      dict set state(vars) $name [dict size $state(vars)]
+      if {[IsInt $name]} {
+        lappend state(intSlots) v[dict get $state(vars) $name]
+      } else {
+        Const $name
+      }
+    }
+    return v[dict get $state(vars) $name]
+  }
+
+  proc Temp {} {
+    variable state
+    return [Var "tmp [incr state(nrTemps)]"]
+  }
+
+  #
+  # Integer constants are kept in integer slots initialized with the
+  # value.
+  #
+  proc IntConst {value} {
+    variable state
+    set value [expr {$value}]
+    dict set state(intValues) "int $value" $value
+    return [Var "int $value"]
+  }
+
+  proc IsIntConst {value} {
+    return [expr {[string is entier -strict $value]
+                  && $value >= -0x80000000 && $value <= 0x7fffffff}]
+  }
+
+  #
+  # Is the variable kept in an integer slot?
+  #
+  proc IsInt {name} {
+    variable state
+    switch -glob -- $name {
+      "tmp *" {return 0}
+      "int *" {return 1}
+    }
+    if {$name in $state(demoted)} {
+      return 0
+    }
+    if {[dict exists $state(args) $name]} {
+      return [expr {[dict get $state(types) $name] eq "int"}]
+    }
+    return 1
+  }
+
+  proc Demote {name} {
+    return -code error -errorcode [list NSF ASM DEMOTE $name] "demote $name"
+  }
+
+  #
+  # The slot type of a value source.
+  #
+  proc Type {source} {
+    lassign $source kind value
+    switch -- $kind {
+      const {return [expr {[IsIntConst $value] ? "int" : "obj"}]}
+      var   {return [expr {[IsInt $value] ? "int" : "obj"}]}
+      default {return obj}
+    }
+  }
+
+  proc Label {} {
+    variable state
+    return L[incr state(nrLabels)]
+  }
+
+  proc Emit {args} {
+    variable state
+    lappend state(code) $args
+  }
+
+  proc Define {name} {
+    variable state
+    if {$name ni $state(defined)} {lappend state(defined) $name}
+    if {[dict exists $state(args) $name] && $name ni $state(assigned)} {
+      lappend state(assigned) $name
+    }
+  }
+
+  #
+  # Return an object slot containing the value of the source, emitting
+  # the code to compute it when needed.
+  #
+  proc ObjSlot {source} {
+    lassign $source kind value
+    switch -- $kind {
+      const {return [Const $value]}
+      var   {
+        if {[IsInt $value]} {
+          set slot [Temp]
+          Emit boxInt slot $slot slot [Var $value]
+          return $slot
+        }
+        return [Var $value]
+      }
+      ivar  {
+        set slot [Temp]
+        Emit getInstVar slot $slot obj [Const $value]
+        return $slot
+      }
+      call  {
+        Call $value
+        set slot [Temp]
+        Emit duplicateResult slot $slot
+        return $slot
+      }
+    }
+  }
+
+  #
+  # Return the integer slot containing the value of a source of type
+  # "int" (an integer constant or a variable kept in an integer slot).
+  #
+  proc IntSlot {source} {
+    lassign $source kind value
+    if {$kind eq "const"} {
+      return [IntConst $value]
+    }
+    return [Var $value]
+  }
+
+  #
+  # Set the result of the method to the value of a slot.
+  #
+  proc SetResult {slot} {
+    variable state
+    if {$slot in $state(intSlots)} {
+      Emit setResultInt slot $slot
+    } else {
+      Emit setResult slot $slot
+    }
+  }
+
+  ######################################################################
+  # Statements
+  ######################################################################
+
+  #
+  # Compile a script. When "tail" is true, the result of the last
+  # command is the result of the method.
+  #
+  proc Block {script tail} {
+    set commands [Commands $script]
+    if {[llength $commands] == 0 && $tail} {
+      Emit setResult slot [Const ""]
+    }
+    set last [expr {[llength $commands] - 1}]
+    set i 0
+    foreach command $commands {
+      set isTail [expr {$tail && $i == $last}]
+      set result [Command $command $isTail]
+      if {$isTail} {
+        switch -- [lindex $result 0] {
+          slot  {SetResult [lindex $result 1]}
+          empty {Emit setResult slot [Const ""]}
+        }
+      }
+      incr i
+    }
+  }
+
+  #
+  # Compile a nested script, variables set in it are not known after
+  # the script.
+  #
+  proc Scope {script tail} {
+    variable state
+    set defined $state(defined)
+    Block $script $tail
+    set state(defined) $defined
+  }
+
+  #
+  # Compile a single command. Returns where its result is: in a slot,
+  # in the interp result, or empty.
+  #
+  proc Command {command tail} {
+    variable state
+    set words [Words $command]
+    lassign [lindex $words 0] kind cmd
+    if {$kind ne "bare"} {Unsupported "command '$cmd'"}
+    set argc [llength $words]
+
+    switch -- $cmd {
+      set {
+        if {$argc != 3} {Unsupported "set with $argc words"}
+        return [Set [lindex $words 1] [Source [lindex $words 2]]]
+      }
+      incr {
+        if {$argc < 2 || $argc > 3} {Unsupported "incr with $argc words"}
+        set name [Name [lindex $words 1]]
+        if {[string index $name 0] eq ":" || $name ni $state(defined)} {
+          Unsupported "incr of variable '$name'"
+        }
+        Define $name
+        set amount [expr {$argc == 3 ? [Source [lindex $words 2]] : {const 1}}]
+        if {[IsInt $name]} {
+          #
+          # Integer slots are only incremented by integer constants,
+          # which keeps them far from overflowing a long; every other
+          # amount might be a bignum or no integer at all.
+          #
+          if {[lindex $amount 0] ne "const" || [Type $amount] ne "int"} {
+            Demote $name
+          }
+          Emit incrInt slot [Var $name] slot [IntSlot $amount]
+        } else {
+          Emit incrObj slot [Var $name] slot [ObjSlot $amount]
+        }
+        return [list slot [Var $name]]
+      }
+      if {
+        If [lrange $words 1 end] $tail
+        return interp
+      }
+      for {
+        if {$argc != 5} {Unsupported "for with $argc words"}
+        lassign $words _ start test next body
+        Block [Script $start] 0
+        set top [Label]; set continue [Label]; set end [Label]
+        Emit label $top
+        Condition [Script $test] $end
+        Loop [Script $body] $continue $end
+        Emit label $continue
+        Scope [Script $next] 0
+        Emit jump instruction $top
+        Emit label $end
+        return empty
+      }
+      while {
+        if {$argc != 3} {Unsupported "while with $argc words"}
+        set top [Label]; set end [Label]
+        Emit label $top
+        Condition [Script [lindex $words 1]] $end
+        Loop [Script [lindex $words 2]] $top $end
+        Emit jump instruction $top
+        Emit label $end
+        return empty
+      }
+      break - continue {
+        if {$argc != 1 || [llength $state(loops)] == 0} {Unsupported $cmd}
+        lassign [lindex $state(loops) end] continue break
+        Emit jump instruction [set $cmd]
+        return empty
+      }
+      return {
+        if {$argc > 2} {Unsupported "return options"}
+        if {$argc == 2} {
+          set source [Source [lindex $words 1]]
+          if {[lindex $source 0] eq "call"} {
+            Call [lindex $source 1]
+          } elseif {[Type $source] eq "int" && [lindex $source 0] eq "var"} {
+            SetResult [Var [lindex $source 1]]
+          } else {
+            SetResult [ObjSlot $source]
+          }
+        } else {
+          Emit setResult slot [Const ""]
+        }
+        Emit jump instruction END
+        return interp
+      }
+      default {
+        Call $command
+        return interp
+      }
+    }
+  }
+
+  proc Script {word} {
+    lassign $word kind text
+    if {$kind ne "braced"} {Unsupported "script '$text'"}
+    return $text
+  }
+
+  proc Name {word} {
+    lassign $word kind name
+    if {$kind ne "bare" || ![regexp {^:?[a-zA-Z_][a-zA-Z0-9_]*$} $name]} {
+      Unsupported "variable name '$name'"
+    }
+    return $name
+  }
+
+  proc Set {word source} {
+    set name [Name $word]
+    if {[string index $name 0] eq ":"} {
+      Emit setInstVar obj [Const [string range $name 1 end]] slot [ObjSlot $source]
+      return interp
+    }
+    lassign $source kind value
+    if {[IsInt $name]} {
+      switch -- [Type $source]-$kind {
+        int-const {Emit setInt slot [Var $name] int [expr {$value}]}
+        int-var   {Emit setIntSlot slot [Var $name] slot [Var $value]}
+        default   {Demote $name}
+      }
+    } else {
+      switch -- $kind {
+        const {Emit duplicateObj slot [Var $name] obj [Const $value]}
+        var   {
+          if {[IsInt $value]} {
+            Emit boxInt slot [Var $name] slot [Var $value]
+          } else {
+            Emit duplicateSlot slot [Var $name] slot [Var $value]
+          }
+        }
+        ivar  {Emit getInstVar slot [Var $name] obj [Const $value]}
+        call  {
+          Call $value
+          Emit duplicateResult slot [Var $name]
+        }
+      }
+    }
+    Define $name
+    return [list slot [Var $name]]
+  }
+
+  proc Loop {body continue break} {
+    variable state
+    lappend state(loops) [list $continue $break]
+    Scope $body 0
+    set state(loops) [lrange $state(loops) 0 end-1]
+  }
+
+  #
+  # if cond ?then? body ?elseif cond ?then? body ...? ?else? ?body?
+  #
+  proc If {words tail} {
+    set end [Label]
+    while {1} {
+      if {[llength $words] < 2} {Unsupported "if syntax"}
+      set words [lassign $words test body]
+      if {[lindex $body 1] eq "then"} {set words [lassign $words body]}
+      set false [Label]
+      Condition [Script $test] $false
+      Scope [Script $body] $tail
+      Emit jump instruction $end
+      Emit label $false
+      if {[llength $words] == 0} {
+        if {$tail} {Emit setResult slot [Const ""]}
+        break
+      }
+      set words [lassign $words keyword]
+      switch -- [lindex $keyword 1] {
+        elseif {continue}
+        else {
+          if {[llength $words] != 1} {Unsupported "if syntax"}
+          Scope [Script [lindex $words 0]] $tail
+          break
+        }
+        default {
+          if {[llength $words] != 0} {Unsupported "if syntax"}
+          Scope [Script $keyword] $tail
+          break
+        }
+      }
+    }
+    Emit label $end
+  }
+
+  #
+  # Compile a comparison, jumping to the label "false" when the
+  # condition does not hold. The engine provides only "<=", on
+  # integer slots (leInt) and on object slots (leIntObj). Only when
+  # both operands are of type "int", the integer slots are compared;
+  # otherwise the operands are compared as objects with the semantics
+  # of expr (e.g. as strings or floating point numbers).
+  #
+  proc Condition {test false} {
+    set words [Words $test]
+    if {[llength $words] != 3} {Unsupported "condition '$test'"}
+    lassign $words left op right
+    set op [lindex $op 1]
+    if {$op ni {< <= > >=}} {Unsupported "operator '$op'"}
+    set sources {}
+    set le leInt
+    foreach operand [list $left $right] {
+      set source [Source $operand]
+      if {[Type $source] ne "int"} {
+        set le leIntObj
+      }
+      lappend sources $source
+    }
+    set slots {}
+    foreach source $sources {
+      lappend slots [expr {$le eq "leInt" ? [IntSlot $source] : [ObjSlot $source]}]
+    }
+    lassign $slots a b
+    switch -- $op {
+      <  {Emit $le slot $b slot $a; Emit jumpTrue instruction $false}
+      >  {Emit $le slot $a slot $b; Emit jumpTrue instruction $false}
+      <= - >= {
+        set true [Label]
+        if {$op eq "<="} {
+          Emit $le slot $a slot $b
+        } else {
+          Emit $le slot $b slot $a
+        }
+        Emit jumpTrue instruction $true
+        Emit jump instruction $false
+        Emit label $true
+      }
+    }
+  }
+
+  #
+  # Compile a self dispatch (": method ..." or ":method ...") or a
+  # dispatch on an object passed as argument ("$obj method ..."). The
+  # dispatch instructions call the methods via inline caches.
+  #
+  proc Call {command} {
+    variable state
+    set words [Words $command]
+    lassign [lindex $words 0] kind first
+    set argv {}
+    if {$kind eq "bare" && $first eq ":"} {
+      set words [lassign [lrange $words 1 end] methodWord]
+      lassign $methodWord kind method
+      set instruction selfDispatch
+    } elseif {$kind eq "bare" && [regexp {^:([a-zA-Z_][a-zA-Z0-9_]*)$} $first _ method]} {
+      set words [lrange $words 1 end]
+      set instruction selfDispatch
+    } elseif {$kind eq "bare" && [llength $words] > 1
+              && [lindex [Source [lindex $words 0]] 0] eq "var"} {
+      set argv [Argument [Source [lindex $words 0]] "method call"]
+      set words [lassign [lrange $words 1 end] methodWord]
+      lassign $methodWord kind method
+      set instruction objDispatch
+    } else {
+      Unsupported "command '$first'"
+    }
+    if {$kind ne "bare" || [regexp {[$\[]} $method]} {
+      Unsupported "dispatch of '$method'"
+    }
+    lappend argv obj [Const $method]
+    foreach word $words {
+      lappend argv {*}[Argument [Source $word] "argument of '$method'"]
+    }
+    Emit $instruction {*}$argv
+  }
+
+  #
+  # Return the instruction argument for a word passed to a method:
+  # constants and (unmodified) method arguments are supported.
+  #
+  proc Argument {source what} {
+    variable state
+    lassign $source kind value
+    switch -- $kind {
+      const {return [list obj [Const $value]]}
+      var {
+        if {![dict exists $state(args) $value]} {
+          Unsupported "local variable '$value' as $what"
+        }
+        lappend state(argRefs) $value
+        return [list arg [dict get $state(args) $value]]
+      }
+      default {Unsupported $what}
+    }
+  }
+
+  ######################################################################
+  # Assembly
+  ######################################################################
+
+  #
+  # Build the asm code: declarations of the constants and variables,
+  # loading the arguments into their slots, followed by the
+  # instructions with resolved slots and labels.
+  #
+  proc Assemble {} {
+    variable state
+    foreach name $state(argRefs) {
+      if {$name in $state(assigned)} {
+        Unsupported "argument '$name' is modified and passed to a method"
+      }
+    }
+    set prologue {}
+    dict for {name position} $state(args) {
+      if {[dict exists $state(vars) $name]} {
+        if {[IsInt $name]} {
+          set instruction unboxInt
+        } elseif {$name in $state(assigned)} {
+          set instruction duplicateObj
+        } else {
+          set instruction setObj
+        }
+        lappend prologue [list $instruction slot [Var $name] arg $position]
+      }
+    }
+
+    set nrConsts [dict size $state(consts)]
+    set asm {}
+    dict for {value index} $state(consts) {
+      lappend asm [list obj $value]
+    }
+    dict for {name index} $state(vars) {
+      if {[IsInt $name]} {
+        set value [expr {[dict exists $state(intValues) $name] ? [dict get $state(intValues) $name] : 0}]
+        lappend asm [list integer int $value]
+      } else {
+        lappend asm [list var obj [string range [Const $name] 1 end]]
+      }
+    }
+
+    set labels {}
+    set n 0
+    set code {}
+    foreach instruction [concat $prologue $state(code)] {
+      if {[lindex $instruction 0] eq "label"} {
+        dict set labels [lindex $instruction 1] $n
+      } else {
+        lappend code $instruction
+        incr n
+      }
+    }
+    dict set labels END $n
+
+    foreach instruction $code {
+      set words [lindex $instruction 0]
+      foreach {type value} [lrange $instruction 1 end] {
+        switch -- $type {
+          slot - obj {
+            set index [string range $value 1 end]
+            if {[string index $value 0] eq "v"} {incr index $nrConsts}
+            lappend words $type $index
+          }
+          instruction {lappend words $type [dict get $labels $value]}
+          default {lappend words $type $value}
+        }
+      }
+      lappend asm $words
+    }
+    return $asm
+  }
+}
+
+interp alias {} ::nsf::asm::compile {} ::nsf::asm::compiler::compile
+
+#
+# Local variables:
+#    mode: tcl
+#    tcl-indent-level: 2
+#    indent-tabs-mode: nil
+# End:
@@ -37,8 +37,32 @@ namespace eval ::nx {
     :object variable failure 0
     :object variable testfile ""
     :object variable ms 0
+    :object variable slower 0
     :object variable case "test"
 
+    #
+    # Options for the timed tests (tests with a count larger than 1),
+    # which can be provided on the command line:
+    #
+    #   -perflog file       append the timings of the tests as dicts
+    #                       (name, iterations, mean, stddev, min) to file
+    #   -perfbaseline file  compare the timings with the ones in a
+    #                       perflog of a previous run
+    #   -perfthreshold f    report tests which are slower than f times
+    #                       the mean in the baseline
+    #   -perfmintime ms     increase the iteration counts such that
+    #                       every sample runs at least ms milliseconds
+    #   -perfsamples n      number of samples per timed test
+    #
+    :object variable perf {
+      -perflog "" -perfbaseline "" -perfthreshold 1.5 -perfmintime 0 -perfsamples 1
+    }
+    if {[llength $::argv] % 2 == 0} {
+      foreach {option value} $::argv {
+	if {[dict exists ${:perf} $option]} {dict set :perf $option $value}
+      }
+    }
+
     :public object method success {} {
       incr :success
     }
@@ -48,17 +72,79 @@ namespace eval ::nx {
     :public object method ms {ms:double} {
       set :ms [expr {${:ms} + $ms}]
     }
+    :public object method perfoption {name} {
+      return [dict get ${:perf} -$name]
+    }
+    :public object method baseline {name} {
+      #
+      # Return the mean time of the named test in the baseline or an
+      # empty string, when the test is not contained in the baseline.
+      #
+      if {![info exists :baseline]} {
+	set :baseline {}
+	set f [open [dict get ${:perf} -perfbaseline]]
+	foreach line [split [read $f] \n] {
+	  if {[dict exists $line name]} {
+	    dict set :baseline [dict get $line name] [dict get $line mean]
+	  }
+	}
+	close $f
+      }
+      if {[dict exists ${:baseline} $name]} {
+	return [dict get ${:baseline} $name]
+      }
+      return ""
+    }
+    :public object method perflog {result} {
+      set f [open [dict get ${:perf} -perflog] a]; puts $f $result; close $f
+    }
+    :public object method slower {} {
+      incr :slower
+    }
+    :public object method statistics {samples} {
+      #
+      # Return minimum, median, mean, maximum and standard deviation
+      # of the samples as a dict (used as well by tests/bench.tcl).
+      #
+      set samples [lsort -real $samples]
+      set n [llength $samples]
+      set sum 0.0
+      foreach s $samples {set sum [expr {$sum + $s}]}
+      set mean [expr {$sum / $n}]
+      set sq 0.0
+      foreach s $samples {set sq [expr {$sq + ($s - $mean) ** 2}]}
+      if {$n % 2} {
+	set median [lindex $samples [expr {$n / 2}]]
+      } else {
+	set median [expr {([lindex $samples [expr {$n / 2 - 1}]] + [lindex $samples [expr {$n / 2}]]) / 2.0}]
+      }
+      return [list \
+		  min [lindex $samples 0] \
+		  median $median \
+		  mean $mean \
+		  max [lindex $samples end] \
+		  stddev [expr {$n > 1 ? sqrt($sq / ($n - 1)) : 0.0}]]
+    }
     :public object method destroy {} {
-      lappend msg \
-	  Test-set [file rootname [file tail ${:testfile}]] \
-	  tests [expr {${:success} + ${:failure}}] \
-	  success ${:success} \
-	  failure ${:failure} \
-	  ms ${:ms} 
-      puts "Summary: $msg\n"
-      array set "" $::argv
-      if {[info exists (-testlog)]} {
-	set f [open $(-testlog) a]; puts $f $msg; close $f
+      #
+      # Report the summary, unless no test was defined (e.g. when the
+      # package is only used for its statistics).
+      #
+      if {${:testfile} ne ""} {
+	lappend msg \
+	    Test-set [file rootname [file tail ${:testfile}]] \
+	    tests [expr {${:success} + ${:failure}}] \
+	    success ${:success} \
+	    failure ${:failure} \
+	    ms ${:ms} 
+	if {[dict get ${:perf} -perfbaseline] ne ""} {
+	  lappend msg slower ${:slower}
+	}
+	puts "Summary: $msg\n"
+	array set "" $::argv
+	if {[info exists (-testlog)]} {
+	  set f [open $(-testlog) a]; puts $f $msg; close $f
+	}
       }
       next
     }
@@ -88,6 +174,8 @@ namespace eval ::nx {
 	foreach o [Object info instances -closure] {
 	  if {[info exists pre_exist($o)]} continue
 	  if {$o in {::xotcl::Attribute}} continue
+	  # keep classes created on demand by nx (e.g. ::nx::CopyHandler)
+	  if {[info exists ::nx::internal::provided($o)]} continue
 	  if {[::nsf::object::exists $o]} {$o destroy}
 	}
       }
@@ -139,16 +227,41 @@ namespace eval ::nx {
 	  #
 	  #set r0 [time {time {::namespace eval ${:namespace} ";"} $c}]
 	  #regexp {^(-?[0-9]+) +} $r0 _ mS0
-	  set r1 [time {time {::namespace eval ${:namespace} ${:cmd}} $c}]
-	  #puts stderr "running {time {::namespace eval ${:namespace} ${:cmd}} $c} => $r1"
-	  regexp {^(-?[0-9]+) +} $r1 _ mS1
-	  #set ms [expr {($mS1 - $mS0) * 1.0 / $c}]
-	  set ms [expr {$mS1 * 1.0 / $c}]
+	  set mintime [::nx::test perfoption perfmintime]
+	  if {$mintime > 0} {
+	    set c [:calibrate $c $mintime]
+	  }
+	  set samples {}
+	  set n [expr {max(1, [::nx::test perfoption perfsamples])}]
+	  for {set i 0} {$i < $n} {incr i} {
+	    set r1 [time {time {::namespace eval ${:namespace} ${:cmd}} $c}]
+	    #puts stderr "running {time {::namespace eval ${:namespace} ${:cmd}} $c} => $r1"
+	    regexp {^(-?[0-9]+) +} $r1 _ mS1
+	    #set ms [expr {($mS1 - $mS0) * 1.0 / $c}]
+	    lappend samples [expr {$mS1 * 1.0 / $c}]
+	  }
+	  set stats [::nx::test statistics $samples]
+	  set ms [dict get $stats mean]
 	  # if for some reason the run of the test is faster than the
 	  # body-less eval, don't report negative values.
 	  #if {$ms < 0} {set ms 0.0}
 	  #puts stderr "[set :name]:\t[format %6.2f $ms]\tmms, ${:msg} (overhead [format %.2f [expr {$mS0*1.0/$c}]])"
-	  puts stderr "[set :name]:\t[format %6.2f $ms]\tmms, ${:msg}"
+	  set compare ""
+	  if {[::nx::test perfoption perfbaseline] ne ""} {
+	    set base [::nx::test baseline ${:name}]
+	    set threshold [::nx::test perfoption perfthreshold]
+	    if {$base ne "" && $base > 0 && $ms > $base * $threshold} {
+	      set compare " SLOWER than baseline [format %.2f $base] mms"
+	      ::nx::test slower
+	    }
+	  }
+	  puts stderr "[set :name]:\t[format %6.2f $ms]\tmms, ${:msg}$compare"
+	  if {[::nx::test perfoption perflog] ne ""} {
+	    ::nx::test perflog [list name ${:name} iterations $c \
+				    mean [format %.4f $ms] \
+				    stddev [format %.4f [dict get $stats stddev]] \
+				    min [format %.4f [dict get $stats min]]]
+	  }
 	} else {
 	  puts stderr "[set :name]: ${:msg} ok"
 	}
@@ -172,6 +285,20 @@ namespace eval ::nx {
       :exitOff
     }
 
+    :method calibrate {count mintime} {
+      #
+      # Increase the iteration count until a single sample takes at
+      # least mintime milliseconds (but bound the count).
+      #
+      while {$count < 10000000} {
+	set us [lindex [time {time {::namespace eval ${:namespace} ${:cmd}} $count}] 0]
+	if {$us >= $mintime * 1000} break
+	set factor [expr {$us > 0 ? ($mintime * 1000.0) / $us : 10.0}]
+	set count [expr {min(10000000, int(ceil($count * min(10.0, max(1.1, $factor)))))}]
+      }
+      return $count
+    }
+
     :public method exit {{statuscode "1"}} {
       array set map {1 ok -1 error}
       set errorcode $map($statuscode)
@@ -2324,12 +2324,53 @@ namespace eval ::nx {
   # remove helper proc
   rename ::nx::createBootstrapVariableSlots ""
 
+  ######################################################################
+  # Classes defined on demand
+  ######################################################################
+  #
+  # Some classes are only needed by a few methods (e.g. "contains",
+  # "copy" and "move"). Instead of creating these classes when nx is
+  # loaded, ::nx::internal::provideClass registers the class body and
+  # a stub command under the class name. The class is created via
+  # ::nx::internal::requireClass, either when the stub is called or
+  # via the unknown handler for objects, when the class is used in a
+  # superclass or class relation. The unknown handler is registered
+  # per class with the class name as pattern, such that lookups of
+  # other unknown objects do not call it.
+  #
+  # Since these classes are created after the default method call
+  # protection and the default accessor are set (see below), their
+  # bodies have to specify the protection explicitly.
+  #
+  proc ::nx::internal::provideClass {name body} {
+    set ::nx::internal::provided($name) $body
+    ::nsf::object::unknown::add nx-provided:$name ::nx::internal::requireClass $name
+    proc $name args [string map [list @name@ $name] {
+      ::nx::internal::requireClass @name@
+      uplevel 1 [list @name@ {*}$args]
+    }]
+  }
+
+  proc ::nx::internal::requireClass {name} {
+    if {![info exists ::nx::internal::provided($name)]
+        || [::nsf::object::exists $name]} {
+      return ""
+    }
+    if {[info commands $name] ne ""} {
+      # remove the stub
+      rename $name ""
+    }
+    ::nsf::object::unknown::delete nx-provided:$name
+    namespace eval ::nx [list Class create $name $::nx::internal::provided($name)]
+    return $name
+  }
+
   ######################################################################
   # Define a scoped "new" method, which is similar to plain new, but
   # uses the current namespace by default as root of the object name.
   ######################################################################
 
-  Class create ::nx::NsScopedNew {
+  ::nx::internal::provideClass ::nx::NsScopedNew {
     :public method new {-childof args} {
       if {![info exists childof]} {
 	#
@@ -2412,13 +2453,13 @@ namespace eval ::nx {
   # copy/move implementation
   ######################################################################
 
-  Class create ::nx::CopyHandler {
+  ::nx::internal::provideClass ::nx::CopyHandler {
 
-    :property {targetList ""}
-    :property {dest ""}
-    :property objLength
+    :property -accessor public {targetList ""}
+    :property -accessor public {dest ""}
+    :property -accessor public objLength
 
-    :method makeTargetList {t} {
+    :public method makeTargetList {t} {
       if {[::nsf::is object,type=::nx::EnsembleObject $t]} {
 	# 
 	# we do not copy ensemble objects, since method
@@ -2454,7 +2495,7 @@ namespace eval ::nx {
     }
 
     # construct destination obj name from old qualified ns name
-    :method getDest {origin} {
+    :public method getDest {origin} {
       if {${:dest} eq ""} {
 	return ""
       } else {
@@ -2463,7 +2504,7 @@ namespace eval ::nx {
       }
     }
 
-    :method copyTargets {} {
+    :public method copyTargets {} {
       #puts stderr "COPY will copy targetList = [set :targetList]"
       set objs {}
       array set cmdMap {alias alias forward forward method create setter setter}
@@ -0,0 +1,229 @@
+# -*- Tcl -*-
+#
+# Benchmark suite for the core dispatch and the object life cycle.
+#
+# Every benchmark is executed a number of runs (after a warm-up run);
+# for every run the time per iteration is measured via [time]. The
+# results are written as JSON with the minimum, median, mean, maximum
+# and standard deviation (all in microseconds per iteration), such
+# that results of different versions can be compared automatically.
+#
+# Usage:
+#
+#    tclsh bench.tcl ?-runs n? ?-scale f? ?-match pattern? ?-output file?
+#
+# "-scale" multiplies the iteration counts of all benchmarks, "-match"
+# restricts the benchmarks to the ones with matching names.
+#
+package require nx
+package require nx::serializer
+package require nx::test
+
+array set opt {-runs 7 -scale 1.0 -match * -output ""}
+array set opt $::argv
+
+namespace eval ::nx::bench {
+  variable benchmarks {}
+
+  #
+  # Register a benchmark: "name" is reported in the results, "setup"
+  # is evaluated once before the runs, "body" is the measured script
+  # and "iterations" is the number of executions per run.
+  #
+  proc bench {name iterations setup body} {
+    variable benchmarks
+    lappend benchmarks [list $name $iterations $setup $body]
+  }
+
+  proc json-string {s} {
+    return "\"[string map {\\ \\\\ \" \\\" \n \\n \t \\t} $s]\""
+  }
+
+  proc json-number {n} {
+    return [format %.4f $n]
+  }
+
+  proc run {runs scale match} {
+    variable benchmarks
+    set results {}
+    foreach b $benchmarks {
+      lassign $b name iterations setup body
+      if {![string match $match $name]} continue
+      set iterations [expr {max(1, int($iterations * $scale))}]
+      namespace eval ::nx::bench::sandbox $setup
+      namespace eval ::nx::bench::sandbox [list time $body $iterations]
+      set times {}
+      for {set i 0} {$i < $runs} {incr i} {
+        lappend times [lindex [namespace eval ::nx::bench::sandbox \
+                                   [list time $body $iterations]] 0]
+      }
+      foreach o [nx::Object info instances -closure ::nx::bench::sandbox::*] {
+        if {[::nsf::object::exists $o]} {$o destroy}
+      }
+      namespace delete ::nx::bench::sandbox
+      set stats [::nx::test statistics $times]
+      puts stderr [format "%-32s %10.3f us (median of %d runs, %d iterations)" \
+                       $name [dict get $stats median] $runs $iterations]
+      lappend results [list $name $iterations $stats]
+    }
+    return $results
+  }
+
+  proc json {runs results} {
+    global tcl_platform
+    set entries {}
+    foreach r $results {
+      lassign $r name iterations stats
+      set fields [list "\"name\": [json-string $name]" "\"iterations\": $iterations"]
+      dict for {key value} $stats {
+        lappend fields "\"$key\": [json-number $value]"
+      }
+      lappend entries "    \{[join $fields {, }]\}"
+    }
+    return [join [list \
+                      "\{" \
+                      "  \"nsf\": [json-string [package require nsf]]," \
+                      "  \"tcl\": [json-string [info patchlevel]]," \
+                      "  \"os\": [json-string "$tcl_platform(os) $tcl_platform(osVersion)"]," \
+                      "  \"machine\": [json-string $tcl_platform(machine)]," \
+                      "  \"unit\": \"microseconds per iteration\"," \
+                      "  \"runs\": $runs," \
+                      "  \"benchmarks\": \[" \
+                      [join $entries ",\n"] \
+                      "  \]" \
+                      "\}"] \n]
+  }
+}
+
+namespace eval ::nx::bench {
+
+  #
+  # Method dispatch
+  #
+  bench method-call 100000 {
+    nx::Class create C {:public method foo {} {return 1}}
+    C create c1
+  } {c1 foo}
+
+  bench method-call-typed-args 100000 {
+    nx::Class create C {:public method foo {a:integer b:alnum -c:boolean} {return $a}}
+    C create c1
+  } {c1 foo 1 abc -c true}
+
+  foreach depth {1 2 4 8} {
+    bench next-chain-$depth 50000 [string map [list @depth@ $depth] {
+      nx::Class create C0 {:public method foo {} {return 1}}
+      for {set i 1} {$i <= @depth@} {incr i} {
+        nx::Class create C$i -superclass C[expr {$i - 1}] {:public method foo {} {next}}
+      }
+      C@depth@ create c1
+    }] {c1 foo}
+  }
+
+  bench mixin-dispatch 100000 {
+    nx::Class create M {:public method foo {} {next}}
+    nx::Class create C {:public method foo {} {return 1}}
+    C create c1 -object-mixins M
+  } {c1 foo}
+
+  bench filter-dispatch 100000 {
+    nx::Class create C {
+      :public method foo {} {return 1}
+      :method f args {next}
+    }
+    C create c1
+    c1 object filters set f
+  } {c1 foo}
+
+  bench setter-call 100000 {
+    nx::Class create C {:property -accessor public {a 1}}
+    C create c1
+  } {c1 a set 2}
+
+  #
+  # An alias to a proc compared with the call of the proc as a method
+  #
+  bench alias-call 100000 {
+    proc ::bench-target {} {return 1}
+    nx::Class create C {:public alias foo ::bench-target}
+    C create c1
+  } {c1 foo}
+
+  bench alias-direct-call 100000 {
+    nx::Class create C {:public method foo {} {return 1}}
+    C create c1
+  } {c1 foo}
+
+  bench forwarder-call 100000 {
+    nx::Class create C {
+      :public method foo {x} {return $x}
+      :public forward fwd %self foo
+    }
+    C create c1
+  } {c1 fwd 1}
+
+  #
+  # Object life cycle
+  #
+  foreach n {0 1 5 10 20} {
+    set properties {}
+    for {set i 0} {$i < $n} {incr i} {lappend properties ":property {p$i $i}"}
+    bench create-destroy-$n 10000 [list nx::Class create C [join $properties \n]] \
+        {[C new] destroy}
+  }
+
+  bench configure 50000 {
+    nx::Class create C {:property a; :property {b 1}}
+    C create c1 -a 0
+  } {c1 configure -a 1 -b 2}
+
+  bench cget 100000 {
+    nx::Class create C {:property a; :property {b 1}}
+    C create c1 -a 0
+  } {c1 cget -b}
+
+  #
+  # Introspection
+  #
+  bench info-vars 50000 {
+    nx::Class create C {:property a; :property {b 1}}
+    C create c1 -a 0
+  } {c1 info vars}
+
+  bench info-lookup-methods 10000 {
+    nx::Class create C {:public method foo {} {return 1}}
+    C create c1
+  } {c1 info lookup methods}
+
+  bench info-class-methods 50000 {
+    nx::Class create C {
+      :public method foo {} {return 1}
+      :public method bar {} {return 1}
+    }
+  } {C info methods}
+
+  #
+  # Serializer round-trip
+  #
+  bench serializer-roundtrip 1000 {
+    nx::Class create C {:property a; :property {b 1}}
+    C create c1 -a 0
+    c1 object method foo {} {return 1}
+  } {set s [c1 serialize]; c1 destroy; eval $s}
+}
+
+set results [::nx::bench::run $opt(-runs) $opt(-scale) $opt(-match)]
+set json [::nx::bench::json $opt(-runs) $results]
+
+if {$opt(-output) ne ""} {
+  set f [open $opt(-output) w]; puts $f $json; close $f
+} else {
+  puts $json
+}
+
+#
+# Local variables:
+#    mode: tcl
+#    tcl-indent-level: 2
+#    indent-tabs-mode: nil
+# End:
@@ -9,7 +9,7 @@ array set opt $::argv
 
 if {[info exists opt(-testlog)]} {
   set f [open $opt(-testlog)]; set content [read $f]; close $f
-  lassign {0 0 0 0 0.0} tests success failures files ms
+  lassign {0 0 0 0 0.0 ""} tests success failures files ms slower
   foreach l [split $content \n] {
     array set "" $l
     if {[info exists (tests)]} {
@@ -18,6 +18,10 @@ if {[info exists opt(-testlog)]} {
       incr success $(success)
       incr files 1
       set ms [expr {$ms + $(ms)}]
+      if {[info exists (slower)]} {
+        set slower [expr {($slower eq "" ? 0 : $slower) + $(slower)}]
+        unset (slower)
+      }
     }
   }
 
@@ -25,6 +29,9 @@ if {[info exists opt(-testlog)]} {
   puts "\tEnvironment: Tcl $tcl_patchLevel, OS $tcl_platform(os) $tcl_platform(osVersion)\
 	machine $tcl_platform(machine) threaded [info exists tcl_platform(threaded)]."
   puts "\tNSF performed $tests tests in $files files, success $success, failures $failures in [expr {$ms / 1000.0}] seconds"
+  if {$slower ne ""} {
+    puts "\t$slower timed tests were slower than the baseline"
+  }
   if {$failures == 0} {
     puts "\tCongratulations, all tests of $opt(-title) passed in your installation of NSF [package req nsf]"
   }